@@ -0,0 +1,156 @@
+#include "gamebryopluginproviders.h"
+
+#include "imodinterface.h"
+#include "imodlist.h"
+#include "imoinfo.h"
+#include "iplugingame.h"
+#include "ipluginlist.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <map>
+
+namespace
+{
+const QString OVERWRITE("<overwrite>");
+
+QStringList listPlugins(QString const& path)
+{
+  return QDir(path).entryList({"*.esp", "*.esl", "*.esm"});
+}
+}  // namespace
+
+GamebryoPluginProviders::GamebryoPluginProviders(MOBase::IOrganizer* organizer)
+    : m_Organizer(organizer), m_State(std::make_shared<State>())
+{
+  std::weak_ptr<State> weak = m_State;
+
+  auto forgetMods = [weak](QStringList const& mods) {
+    if (auto state = weak.lock()) {
+      std::lock_guard lock(state->Mutex);
+      forget(*state, mods);
+    }
+  };
+
+  // a mod installed over an existing one may have different plugins
+  m_Organizer->modList()->onModInstalled([forgetMods](MOBase::IModInterface* mod) {
+    forgetMods({mod->name()});
+  });
+  m_Organizer->modList()->onModRemoved([forgetMods](QString const& mod) {
+    forgetMods({mod});
+  });
+  m_Organizer->modList()->onModStateChanged(
+      [forgetMods](std::map<QString, MOBase::IModList::ModStates> const& mods) {
+        QStringList names;
+        names.reserve(static_cast<qsizetype>(mods.size()));
+        for (auto const& entry : mods) {
+          names.append(entry.first);
+        }
+        forgetMods(names);
+      });
+  m_Organizer->modList()->onModMoved([forgetMods](QString const& mod, int, int) {
+    forgetMods({mod});
+  });
+
+  // another profile enables a whole other set of mods
+  m_Organizer->onProfileChanged([weak](MOBase::IProfile*, MOBase::IProfile*) {
+    if (auto state = weak.lock()) {
+      std::lock_guard lock(state->Mutex);
+      state->ModPlugins.clear();
+      state->DataMods.clear();
+      state->Valid = false;
+    }
+  });
+
+  // a refresh is when MO2 notices that files changed inside a mod, in the data
+  // directory or in the overwrite, the mods are listed again on the next lookup
+  // only if their directory changed
+  m_Organizer->pluginList()->onRefreshed([weak] {
+    if (auto state = weak.lock()) {
+      std::lock_guard lock(state->Mutex);
+      state->ModPlugins.remove(OVERWRITE);
+      forget(*state, {});
+    }
+  });
+}
+
+QStringList GamebryoPluginProviders::providers(QString const& plugin) const
+{
+  std::lock_guard lock(m_State->Mutex);
+  if (!m_State->Valid) {
+    rebuild(*m_State);
+  }
+  return m_State->Providers.value(plugin);
+}
+
+void GamebryoPluginProviders::forget(State& state, QStringList const& mods)
+{
+  for (QString const& mod : mods) {
+    state.ModPlugins.remove(mod);
+  }
+  for (QString const& mod : state.DataMods) {
+    state.ModPlugins.remove(mod);
+  }
+  state.Valid = false;
+}
+
+void GamebryoPluginProviders::rebuild(State& state) const
+{
+  const QStringList mods = m_Organizer->modList()->allModsByProfilePriority();
+  const QString dataDir  = m_Organizer->managedGame()->dataDirectory().absolutePath();
+
+  // only list the mods that are new, were dropped or whose directory changed since
+  // they were listed, and forget the ones that are gone, e.g. renamed
+  QHash<QString, State::Plugins> modPlugins;
+  modPlugins.reserve(mods.size() + 1);
+  state.DataMods.clear();
+  for (QString const& mod : mods) {
+    MOBase::IModInterface* modInfo = m_Organizer->modList()->getMod(mod);
+    if (modInfo == nullptr) {
+      continue;
+    }
+
+    const QString path       = modInfo->absolutePath();
+    const QDateTime modified = QFileInfo(path).lastModified();
+    if (path == dataDir) {
+      state.DataMods.insert(mod);
+    }
+
+    auto iter = state.ModPlugins.constFind(mod);
+    if (iter != state.ModPlugins.constEnd() && iter->Modified == modified) {
+      modPlugins.insert(mod, *iter);
+      continue;
+    }
+
+    QStringList plugins = listPlugins(path);
+    if (path == dataDir) {
+      // We have to prune esps that reside in the data directory, otherwise
+      // you get all the unmanaged mods listed as potential candidates for
+      // enabling
+      plugins.removeIf([&](QString const& esp) {
+        return m_Organizer->pluginList()->origin(esp) != mod;
+      });
+    }
+    modPlugins.insert(mod, {modified, plugins});
+  }
+
+  auto overwrite = state.ModPlugins.constFind(OVERWRITE);
+  if (overwrite != state.ModPlugins.constEnd()) {
+    modPlugins.insert(OVERWRITE, *overwrite);
+  } else {
+    modPlugins.insert(OVERWRITE, {{}, listPlugins(m_Organizer->overwritePath())});
+  }
+  state.ModPlugins = std::move(modPlugins);
+
+  state.Providers.clear();
+  for (QString const& mod : mods) {
+    for (QString const& esp : state.ModPlugins.value(mod).Names) {
+      state.Providers[esp].append(mod);
+    }
+  }
+  for (QString const& esp : state.ModPlugins.value(OVERWRITE).Names) {
+    state.Providers[esp].append(OVERWRITE);
+  }
+  state.Valid = true;
+}
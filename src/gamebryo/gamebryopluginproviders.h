@@ -0,0 +1,78 @@
+#ifndef GAMEBRYOPLUGINPROVIDERS_H
+#define GAMEBRYOPLUGINPROVIDERS_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <mutex>
+
+namespace MOBase
+{
+class IOrganizer;
+}
+
+/**
+ * @brief Reverse index from the name of a plugin to the mods that provide it.
+ *
+ * The plugins of each mod are listed once and kept until the mod is installed
+ * again, removed, enabled, disabled or moved, or until its directory changes, and
+ * the index is rebuilt from these lists when one of them is dropped, so looking up
+ * a plugin does not touch the disk after that. Switching profiles drops them all.
+ */
+class GamebryoPluginProviders
+{
+public:
+  // registers the callbacks on the mod list, the plugin list and the profile
+  explicit GamebryoPluginProviders(MOBase::IOrganizer* organizer);
+
+  /**
+   * @return the names of the mods containing the plugin, in profile priority,
+   *     followed by "<overwrite>" if it is in the overwrite.
+   *
+   * Mods in the data directory are only listed for the plugins they are the
+   * origin of, otherwise every unmanaged mod would provide every plugin in it.
+   */
+  QStringList providers(QString const& plugin) const;
+
+private:
+  struct State
+  {
+    std::mutex Mutex;
+
+    struct Plugins
+    {
+      // of the directory of the mod when it was listed, which adding or removing
+      // a plugin changes
+      QDateTime Modified;
+      QStringList Names;
+    };
+
+    // plugins of each mod listed so far, by mod name
+    QHash<QString, Plugins> ModPlugins;
+
+    // mods in the data directory, whose plugins depend on the other mods
+    QSet<QString> DataMods;
+
+    // built from the lists above, empty until the first lookup after a change
+    QHash<QString, QStringList> Providers;
+    bool Valid = false;
+  };
+
+  // drop the plugins of the given mods, and of the mods in the data directory,
+  // which depend on where the other mods are and whether they are enabled
+  static void forget(State& state, QStringList const& mods);
+
+  void rebuild(State& state) const;
+
+  MOBase::IOrganizer* m_Organizer;
+
+  // shared with the callbacks, which cannot be unregistered and may outlive
+  // the index
+  std::shared_ptr<State> m_State;
+};
+
+#endif  // GAMEBRYOPLUGINPROVIDERS_H
@@ -0,0 +1,55 @@
+#include "gamebryopluginstates.h"
+
+#include "imoinfo.h"
+
+#include <QStringList>
+
+#include <map>
+
+MOBase::IPluginList::PluginState
+GamebryoPluginStates::Snapshot::state(QString const& name) const
+{
+  return States.value(name.toLower(), MOBase::IPluginList::STATE_MISSING);
+}
+
+GamebryoPluginStates::GamebryoPluginStates(MOBase::IOrganizer* organizer)
+    : m_Organizer(organizer), m_Version(std::make_shared<std::atomic<uint64_t>>(1))
+{
+  std::weak_ptr<std::atomic<uint64_t>> weak = m_Version;
+  auto bump = [weak] {
+    if (auto version = weak.lock()) {
+      ++*version;
+    }
+  };
+
+  m_Organizer->pluginList()->onRefreshed(bump);
+  m_Organizer->pluginList()->onPluginStateChanged(
+      [bump](std::map<QString, MOBase::IPluginList::PluginStates> const&) {
+        bump();
+      });
+}
+
+std::shared_ptr<const GamebryoPluginStates::Snapshot>
+GamebryoPluginStates::snapshot() const
+{
+  std::lock_guard lock(m_Mutex);
+
+  // read before taking the states, so a change while they are taken is not lost
+  const uint64_t version = *m_Version;
+  if (m_Snapshot && m_Snapshot->Version == version) {
+    return m_Snapshot;
+  }
+
+  auto snapshot     = std::make_shared<Snapshot>();
+  snapshot->Version = version;
+
+  MOBase::IPluginList* pluginList = m_Organizer->pluginList();
+  const QStringList names         = pluginList->pluginNames();
+  snapshot->States.reserve(names.size());
+  for (QString const& name : names) {
+    snapshot->States.insert(name.toLower(), pluginList->state(name));
+  }
+
+  m_Snapshot = std::move(snapshot);
+  return m_Snapshot;
+}
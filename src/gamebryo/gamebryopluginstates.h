@@ -0,0 +1,62 @@
+#ifndef GAMEBRYOPLUGINSTATES_H
+#define GAMEBRYOPLUGINSTATES_H
+
+#include "ipluginlist.h"
+
+#include <QHash>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace MOBase
+{
+class IOrganizer;
+}
+
+/**
+ * @brief Copy of the states of all the plugins in the plugin list, taken again
+ *     only when the list changes.
+ *
+ * Asking the plugin list for the state of each plugin of a save goes through
+ * the organizer every time, while the list itself rarely changes between two
+ * tooltips.
+ */
+class GamebryoPluginStates
+{
+public:
+  struct Snapshot
+  {
+    // version of the plugin list the states were taken from
+    uint64_t Version = 0;
+
+    // states by lowercase plugin name
+    QHash<QString, MOBase::IPluginList::PluginState> States;
+
+    // plugins that are not in the list are missing, as for the plugin list
+    MOBase::IPluginList::PluginState state(QString const& name) const;
+  };
+
+  // registers the callbacks on the plugin list
+  explicit GamebryoPluginStates(MOBase::IOrganizer* organizer);
+
+  /**
+   * @return the states of the current plugin list, which are taken again first if
+   *     the list changed since the last call. The snapshot is not updated, so it
+   *     should not be kept once the caller returns to the event loop.
+   */
+  std::shared_ptr<const Snapshot> snapshot() const;
+
+private:
+  MOBase::IOrganizer* m_Organizer;
+
+  // bumped by the callbacks, which may outlive this
+  std::shared_ptr<std::atomic<uint64_t>> m_Version;
+
+  mutable std::mutex m_Mutex;
+  mutable std::shared_ptr<const Snapshot> m_Snapshot;
+};
+
+#endif  // GAMEBRYOPLUGINSTATES_H
@@ -1,17 +1,22 @@
 #ifndef GAMEBRYOSAVEGAME_H
 #define GAMEBRYOSAVEGAME_H
 
+#include "gamebryopluginnames.h"
+#include "gamebryosavefile.h"
+#include "gamebryosaveheader.h"
 #include "isavegame.h"
 #include "memoizedlock.h"
 
 #include <QDateTime>
-#include <QFile>
 #include <QImage>
 #include <QString>
 #include <QStringList>
 
-#include <stddef.h>
-#include <stdexcept>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
 
 struct _SYSTEMTIME;
 
@@ -22,7 +27,9 @@ class IPluginGame;
 
 class GameGamebryo;
 
-class GamebryoSaveGame : public MOBase::ISaveGame
+// Saves are shared, see loadDataFieldsAsync().
+class GamebryoSaveGame : public MOBase::ISaveGame,
+                         public std::enable_shared_from_this<GamebryoSaveGame>
 {
 public:
   GamebryoSaveGame(QString const& file, GameGamebryo const* game,
@@ -40,6 +47,12 @@ public:  // ISaveGame interface
 public:
   bool hasScriptExtenderFile() const;
 
+  // Record whether the script extender co-save of this save exists and whether
+  // the game has a script extender, e.g. from a listing of the directory, so that
+  // allFiles() and hasScriptExtenderFile() do not have to check. Both are
+  // otherwise checked on first use and remembered.
+  void setScriptExtenderFile(bool exists, bool hasScriptExtender) const;
+
   // Simple getters
   virtual QString getPCName() const { return m_PCName; }
   virtual unsigned short getPCLevel() const { return m_PCLevel; }
@@ -57,150 +70,75 @@ public:
   }
   QImage const& getScreenshot() const { return m_DataFields.value()->Screenshot; }
 
-  bool isMediumEnabled() const { return m_MediumEnabled; }
-
-  bool isLightEnabled() const { return m_LightEnabled; }
-
-  enum class StringType
+  // Ids of the plugins above in GamebryoPluginNames, in the same order, which are
+  // cheaper to compare than the names. The names themselves share their storage
+  // with the pool.
+  using PluginIdList = std::vector<GamebryoPluginNames::Id>;
+  PluginIdList const& getPluginIds() const { return m_DataFields.value()->PluginIds; }
+  PluginIdList const& getMediumPluginIds() const
   {
-    TYPE_BZSTRING,
-    TYPE_BSTRING,
-    TYPE_WSTRING
-  };
+    return m_DataFields.value()->MediumPluginIds;
+  }
+  PluginIdList const& getLightPluginIds() const
+  {
+    return m_DataFields.value()->LightPluginIds;
+  }
 
-  enum class StringFormat
+  // The fields above are slow to load and the getters block until they are, so
+  // the status can be checked first and the following getters return nullptr
+  // instead of blocking while the fields are not ready.
+  enum class DataFieldsStatus
   {
-    UTF8,
-    LOCAL8BIT
+    NOT_LOADED,
+    LOADING,
+    READY
   };
 
-protected:
-  friend class FileWrapper;
+  DataFieldsStatus dataFieldsStatus() const { return m_DataFieldsStatus; }
 
-  class FileWrapper
+  QStringList const* tryGetPlugins() const { return tryGet(&DataFields::Plugins); }
+  QStringList const* tryGetMediumPlugins() const
   {
-  public:
-    /**
-     * @brief Construct the save file information.
-     *
-     * @param filepath The path to the save file.
-     * @params expected Expecte bytes at start of file.
-     *
-     **/
-    FileWrapper(QString const& filepath, QString const& expected);
-
-    /** Set this for save games that have a marker at the end of each
-     * field. Specifically fallout
-     **/
-    void setHasFieldMarkers(bool);
-
-    /** Set bz string mode (1 byte length, null terminated)
-     **/
-    void setPluginString(StringType);
-
-    /** Set string format (utf-8, windows local 8 bit strings)
-     **/
-    void setPluginStringFormat(StringFormat);
-
-    template <typename T>
-    void skip(int count = 1)
-    {
-      if (!m_File.seek(m_File.pos() + count * sizeof(T))) {
-        throw std::runtime_error("unexpected end of file");
-      }
-    }
-
-    template <typename T>
-    void read(T& value)
-    {
-      int read = m_File.read(reinterpret_cast<char*>(&value), sizeof(T));
-      if (read != sizeof(T)) {
-        throw std::runtime_error("unexpected end of file");
-      }
-      if (m_HasFieldMarkers) {
-        skip<char>();
-      }
-    }
-
-    template <>
-    void read<QString>(QString& value);
-
-    void seek(unsigned long pos)
-    {
-      if (!m_File.seek(pos)) {
-        throw std::runtime_error("unexpected end of file");
-      }
-    }
-
-    void read(void* buff, std::size_t length);
-
-    /* Reads RGB image from save
-     * Assumes picture dimentions come immediately before the save
-     */
-    QImage readImage(int scale = 0, bool alpha = false);
-
-    /* Reads RGB image from save */
-    QImage readImage(unsigned long width, unsigned long height, int scale = 0,
-                     bool alpha = false);
-
-    /* Sets the compression type. */
-    void setCompressionType(uint16_t type);
-
-    /* uncompress the begining of the compressed block */
-    bool openCompressedData(int bytesToIgnore = 0);
-
-    /* read the next compressed block */
-    bool readNextChunk();
-
-    /* frees the uncompressed block */
-    void closeCompressedData();
-
-    /* Read the save game version in the compressed block */
-    uint8_t readChar(int bytesToIgnore = 0);
-
-    uint16_t readShort(int bytesToIgnore = 0);
-
-    uint32_t readInt(int bytesToIgnore = 0);
-
-    uint64_t readLong(int bytesToIgnore = 0);
-
-    float_t readFloat(int bytesToIgnore = 0);
+    return tryGet(&DataFields::MediumPlugins);
+  }
+  QStringList const* tryGetLightPlugins() const
+  {
+    return tryGet(&DataFields::LightPlugins);
+  }
+  QImage const* tryGetScreenshot() const { return tryGet(&DataFields::Screenshot); }
 
-    /* Read the plugin list */
-    QStringList readPlugins(int bytesToIgnore = 0, int extraData = 0,
-                            const QStringList& corePlugins = {});
+  // Load the fields above for the given saves on a background pool, in order, so
+  // visible saves should come first. Saves still queued from a previous call are
+  // dropped, and saves that are destroyed before their turn are skipped.
+  static void
+  prefetchDataFields(std::vector<std::shared_ptr<const GamebryoSaveGame>> const& saves);
 
-    /* Read the light plugin list */
-    QStringList readLightPlugins(int bytesToIgnore = 0, int extraData = 0,
-                                 const QStringList& corePlugins = {});
+  // Drop the saves still queued by prefetchDataFields(), saves already being
+  // loaded are not interrupted.
+  static void cancelPrefetch();
 
-    /* Read the medium plugin list */
-    QStringList readMediumPlugins(int bytesToIgnore = 0, int extraData = 0,
-                                  const QStringList& corePlugins = {});
+  // Load the fields above for the given save on the same pool, ahead of the saves
+  // queued by prefetchDataFields(), e.g. for a save that is being shown, then call
+  // `done` on the main thread with whether they could be loaded. The save is kept
+  // alive until then.
+  static void loadDataFieldsAsync(std::shared_ptr<const GamebryoSaveGame> const& save,
+                                  std::function<void(bool)> done);
 
-    void close();
+  bool isMediumEnabled() const { return m_MediumEnabled; }
 
-  private:
-    QFile m_File;
-    uint64_t m_NextChunk;
-    uint64_t m_UncompressedSize;
-    bool m_HasFieldMarkers;
-    StringType m_PluginString;
-    StringFormat m_PluginStringFormat;
-    QDataStream* m_Data;
-    uint16_t m_CompressionType = 0;
+  bool isLightEnabled() const { return m_LightEnabled; }
 
-  private:
-    template <typename T>
-    void readQDataStream(QDataStream& data, T& value);
+  using StringType   = GamebryoSaveFile::StringType;
+  using StringFormat = GamebryoSaveFile::StringFormat;
 
-    void readQDataStream(QDataStream& data, void* buff, std::size_t length);
+protected:
+  // Used when the header fields are already known, from the save game cache or a
+  // probe, to avoid touching the file, see GameGamebryo::makeSaveGame().
+  GamebryoSaveGame(QString const& file, GameGamebryo const* game,
+                   GamebryoSaveHeader const& header);
 
-    void skipQDataStream(QDataStream& data, std::size_t length);
-
-    QStringList readPluginData(uint32_t count, int extraData,
-                               const QStringList corePlugins);
-  };
+  // kept under this name for the game plugins
+  using FileWrapper = GamebryoSaveFile;
 
   void setCreationTime(_SYSTEMTIME const& time);
 
@@ -212,7 +150,7 @@ protected:
   QString m_PCName;
   unsigned short m_PCLevel;
   QString m_PCLocation;
-  unsigned long m_SaveNumber;
+  uint32_t m_SaveNumber;
   QDateTime m_CreationTime;
 
   // Those three fields are usually much slower to fetch than
@@ -227,14 +165,48 @@ protected:
     QStringList MediumPlugins;
     QImage Screenshot;
 
+    // Filled from the lists above once they are fetched.
+    PluginIdList PluginIds;
+    PluginIdList LightPluginIds;
+    PluginIdList MediumPluginIds;
+
     // We need this constructor.
     DataFields() {}
     virtual ~DataFields() {}
   };
   MOBase::MemoizedLocked<std::unique_ptr<DataFields>> m_DataFields;
+  mutable std::atomic<DataFieldsStatus> m_DataFieldsStatus =
+      DataFieldsStatus::NOT_LOADED;
 
   // Fetch the field.
   virtual std::unique_ptr<DataFields> fetchDataFields() const = 0;
+
+private:
+  // Calls fetchDataFields(), interns the plugin names and keeps track of the
+  // status.
+  std::unique_ptr<DataFields> loadDataFields() const;
+
+  QString scriptExtenderFilePath() const;
+
+  // whether the co-save exists and whether the game has a script extender, see
+  // setScriptExtenderFile(), as the bits below
+  enum ScriptExtenderState : uint8_t
+  {
+    SE_FILE_KNOWN   = 1,
+    SE_FILE_EXISTS  = 2,
+    SE_KNOWN        = 4,
+    SE_HAS_EXTENDER = 8
+  };
+  mutable std::atomic<uint8_t> m_ScriptExtenderState = 0;
+
+  template <typename T>
+  T const* tryGet(T DataFields::*field) const
+  {
+    if (m_DataFieldsStatus != DataFieldsStatus::READY) {
+      return nullptr;
+    }
+    return &(m_DataFields.value().get()->*field);
+  }
 };
 
 #endif  // GAMEBRYOSAVEGAME_H
@@ -0,0 +1,153 @@
+#include "gamebryosavegamecache.h"
+
+#include "log.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+
+namespace
+{
+// "MOSC", followed by the format version, bump it whenever Entry changes
+constexpr quint32 CACHE_MAGIC   = 0x4D4F5343;
+constexpr quint32 CACHE_VERSION = 2;
+
+// sanity limit when loading, anything above is considered corrupted
+constexpr quint32 MAX_ENTRIES = 1 << 20;
+}  // namespace
+
+GamebryoSaveGameCache::GamebryoSaveGameCache(QDir const& folder)
+    : m_Path(cachePath(folder))
+{}
+
+QString GamebryoSaveGameCache::cachePath(QDir const& folder)
+{
+  return folder.absolutePath() + ".mo2savecache";
+}
+
+void GamebryoSaveGameCache::load()
+{
+  m_Entries.clear();
+  m_Modified = false;
+
+  QFile file(m_Path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_15);
+
+  quint32 magic, version, count;
+  stream >> magic >> version >> count;
+  if (stream.status() != QDataStream::Ok || magic != CACHE_MAGIC ||
+      version != CACHE_VERSION || count > MAX_ENTRIES) {
+    return;
+  }
+
+  QHash<QString, Entry> entries;
+  entries.reserve(count);
+  for (quint32 i = 0; i < count; ++i) {
+    QString name;
+    Entry entry;
+    GamebryoSaveHeader& header = entry.Header;
+    stream >> name >> entry.Size >> entry.LastModified >> header.PCName >>
+        header.PCLevel >> header.PCLocation >> header.SaveNumber >>
+        header.CreationTime >> header.LightEnabled >> header.MediumEnabled;
+
+    if (stream.status() != QDataStream::Ok) {
+      break;
+    }
+    entries.insert(name, entry);
+  }
+
+  // a truncated or otherwise damaged file is dropped as a whole, it will be
+  // rebuilt from the saves
+  if (stream.status() != QDataStream::Ok || !stream.atEnd()) {
+    MOBase::log::warn("ignoring corrupted save game cache '{}'", m_Path);
+    m_Modified = true;
+    return;
+  }
+
+  m_Entries = std::move(entries);
+}
+
+void GamebryoSaveGameCache::save()
+{
+  if (!m_Modified) {
+    return;
+  }
+
+  // write to a temporary file and rename it, so that the cache is never left
+  // half written
+  QSaveFile file(m_Path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    MOBase::log::warn("failed to write save game cache '{}'", m_Path);
+    return;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_15);
+
+  stream << CACHE_MAGIC << CACHE_VERSION << static_cast<quint32>(m_Entries.size());
+  for (auto it = m_Entries.cbegin(); it != m_Entries.cend(); ++it) {
+    const Entry& entry               = it.value();
+    const GamebryoSaveHeader& header = entry.Header;
+    stream << it.key() << entry.Size << entry.LastModified << header.PCName
+           << header.PCLevel << header.PCLocation << header.SaveNumber
+           << header.CreationTime << header.LightEnabled << header.MediumEnabled;
+  }
+
+  if (stream.status() != QDataStream::Ok || !file.commit()) {
+    MOBase::log::warn("failed to write save game cache '{}'", m_Path);
+    return;
+  }
+
+  m_Modified = false;
+}
+
+std::optional<GamebryoSaveGameCache::Entry>
+GamebryoSaveGameCache::find(QFileInfo const& file) const
+{
+  auto it = m_Entries.constFind(file.fileName());
+  if (it == m_Entries.cend() || it->Size != file.size() ||
+      it->LastModified != file.lastModified().toMSecsSinceEpoch()) {
+    return {};
+  }
+  return *it;
+}
+
+void GamebryoSaveGameCache::insert(QFileInfo const& file, GamebryoSaveGame const& save)
+{
+  Entry entry;
+  entry.Size                 = file.size();
+  entry.LastModified         = file.lastModified().toMSecsSinceEpoch();
+  entry.Header.PCName        = save.getPCName();
+  entry.Header.PCLevel       = save.getPCLevel();
+  entry.Header.PCLocation    = save.getPCLocation();
+  entry.Header.SaveNumber    = save.getSaveNumber();
+  entry.Header.CreationTime  = save.getCreationTime();
+  entry.Header.LightEnabled  = save.isLightEnabled();
+  entry.Header.MediumEnabled = save.isMediumEnabled();
+
+  m_Entries.insert(file.fileName(), entry);
+  m_Modified = true;
+}
+
+void GamebryoSaveGameCache::prune(QFileInfoList const& files)
+{
+  QSet<QString> names;
+  for (auto& file : files) {
+    names.insert(file.fileName());
+  }
+
+  for (auto it = m_Entries.begin(); it != m_Entries.end();) {
+    if (!names.contains(it.key())) {
+      it         = m_Entries.erase(it);
+      m_Modified = true;
+    } else {
+      ++it;
+    }
+  }
+}
@@ -0,0 +1,79 @@
+#ifndef GAMEBRYOSAVEGAMECACHE_H
+#define GAMEBRYOSAVEGAMECACHE_H
+
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QString>
+
+#include <optional>
+
+#include "gamebryosavegame.h"
+#include "gamebryosaveheader.h"
+
+/**
+ * @brief On-disk cache of the fields parsed from save headers.
+ *
+ * The cache is a single binary file stored next to the saves directory, with
+ * one entry per save keyed by file name, size and modification time, so that
+ * unchanged saves can be listed without opening them. A cache file that cannot
+ * be read, for any reason, is simply treated as empty.
+ *
+ * Only the header fields are cached, the saves are created from them by the
+ * game (see GameGamebryo::makeSaveGame()) so that they have the game's own
+ * type, and parse the rest of the file themselves when it is needed.
+ */
+class GamebryoSaveGameCache
+{
+public:
+  struct Entry
+  {
+    qint64 Size;
+    qint64 LastModified;
+    GamebryoSaveHeader Header;
+  };
+
+  /**
+   * @param folder The saves directory this cache is for.
+   */
+  GamebryoSaveGameCache(QDir const& folder);
+
+  /**
+   * @return the path of the cache file for the given saves directory.
+   */
+  static QString cachePath(QDir const& folder);
+
+  /**
+   * @brief Load the cache from disk, leaving it empty if the file is missing,
+   *     from another version or corrupted.
+   */
+  void load();
+
+  /**
+   * @brief Write the cache back to disk if it has been modified.
+   */
+  void save();
+
+  /**
+   * @return the entry for the given file if it has not changed since it was
+   *     cached.
+   */
+  std::optional<Entry> find(QFileInfo const& file) const;
+
+  /**
+   * @brief Add or replace the entry for the given save.
+   */
+  void insert(QFileInfo const& file, GamebryoSaveGame const& save);
+
+  /**
+   * @brief Remove the entries for files that are not in the given list.
+   */
+  void prune(QFileInfoList const& files);
+
+private:
+  QString m_Path;
+  QHash<QString, Entry> m_Entries;
+  bool m_Modified = false;
+};
+
+#endif  // GAMEBRYOSAVEGAMECACHE_H
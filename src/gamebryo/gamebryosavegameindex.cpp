@@ -0,0 +1,249 @@
+#include "gamebryosavegameindex.h"
+
+#include "gamebryosavegame.h"
+#include "gamegamebryo.h"
+#include "imoinfo.h"
+#include "scriptextender.h"
+
+#include <QFileInfo>
+#include <QSet>
+#include <QThread>
+
+#include <algorithm>
+
+namespace
+{
+// order of the saves in a group
+bool olderThan(std::shared_ptr<const GamebryoSaveGame> const& a,
+               std::shared_ptr<const GamebryoSaveGame> const& b)
+{
+  if (a->getSaveNumber() != b->getSaveNumber()) {
+    return a->getSaveNumber() < b->getSaveNumber();
+  }
+  return a->getCreationTime() < b->getCreationTime();
+}
+}  // namespace
+
+GamebryoSaveGameIndex::GamebryoSaveGameIndex(GameGamebryo const* game,
+                                             QDir const& folder)
+    : m_Game(game), m_Folder(folder), m_Watcher(this), m_Debounce(this)
+{
+  m_Debounce.setSingleShot(true);
+  m_Debounce.setInterval(DEBOUNCE_MS);
+  connect(&m_Debounce, &QTimer::timeout, this, &GamebryoSaveGameIndex::refresh);
+  connect(&m_Watcher, &QFileSystemWatcher::directoryChanged, this,
+          &GamebryoSaveGameIndex::onDirectoryChanged);
+
+  // the index may still be moved to another thread, so the directory is watched
+  // from the thread it ends up on, notifications need an event loop there anyway
+  // and without one changes are only seen by the next call to saves()
+  QMetaObject::invokeMethod(
+      this,
+      [this] {
+        m_Watcher.addPath(m_Folder.absolutePath());
+      },
+      Qt::QueuedConnection);
+}
+
+std::vector<std::shared_ptr<const GamebryoSaveGame>>
+GamebryoSaveGameIndex::saves(GamebryoSaveStats::Report* report)
+{
+  std::vector<std::shared_ptr<const GamebryoSaveGame>> result;
+  Changes changes;
+  {
+    std::lock_guard lock(m_Mutex);
+
+    // always list the directory, a pending notification may not have been
+    // delivered yet and saves rewritten in place are not notified at all
+    changes = update(report);
+
+    result.reserve(m_Order.size());
+    for (auto& path : m_Order) {
+      auto it = m_Saves.constFind(path);
+      if (it != m_Saves.cend() && it->Save) {
+        result.push_back(it->Save);
+      }
+    }
+  }
+  notify(changes);
+  return result;
+}
+
+QStringList GamebryoSaveGameIndex::groups()
+{
+  QStringList result;
+  Changes changes;
+  {
+    std::lock_guard lock(m_Mutex);
+    changes = update(nullptr);
+    result  = m_Groups.keys();
+  }
+  notify(changes);
+  return result;
+}
+
+GamebryoSaveGameIndex::Group GamebryoSaveGameIndex::group(QString const& identifier)
+{
+  Group result;
+  Changes changes;
+  {
+    std::lock_guard lock(m_Mutex);
+    changes = update(nullptr);
+    auto it = m_Groups.constFind(identifier);
+    if (it != m_Groups.cend()) {
+      result = *it;
+    }
+  }
+  notify(changes);
+  return result;
+}
+
+GamebryoSaveGameIndex::Group
+GamebryoSaveGameIndex::allButNewest(QString const& identifier, std::size_t keep)
+{
+  Group saves = group(identifier);
+  if (saves.size() <= keep) {
+    return {};
+  }
+  saves.resize(saves.size() - keep);
+  return saves;
+}
+
+void GamebryoSaveGameIndex::refresh()
+{
+  Changes changes;
+  {
+    std::lock_guard lock(m_Mutex);
+    changes = update(nullptr);
+  }
+  notify(changes);
+}
+
+void GamebryoSaveGameIndex::notify(Changes const& changes)
+{
+  if (!changes.Updated.isEmpty() || !changes.Removed.isEmpty()) {
+    emit savesChanged(changes.Updated, changes.Removed);
+  }
+}
+
+GamebryoSaveGameIndex::Changes
+GamebryoSaveGameIndex::update(GamebryoSaveStats::Report* report)
+{
+  // the timer can only be stopped from its thread, a refresh it would still run is
+  // cheap when nothing changed
+  if (QThread::currentThread() == thread()) {
+    m_Debounce.stop();
+  }
+
+  // list the directory once for both the saves and the script extender co-saves,
+  // which saves check otherwise
+  const QString extension   = "." + m_Game->savegameExtension();
+  const QString seExtension = "." + m_Game->savegameSEExtension();
+  QFileInfoList files;
+  QSet<QString> coSaves;
+  for (auto& file : m_Folder.entryInfoList(QDir::Files)) {
+    if (file.fileName().endsWith(extension, Qt::CaseInsensitive)) {
+      files.push_back(file);
+    } else if (file.fileName().endsWith(seExtension, Qt::CaseInsensitive)) {
+      coSaves.insert(file.completeBaseName().toLower());
+    }
+  }
+
+  // find the files that are new or changed since the last refresh
+  QFileInfoList changed;
+  QStringList order;
+  order.reserve(files.size());
+  for (auto& file : files) {
+    order.push_back(file.filePath());
+    auto it = m_Saves.constFind(file.filePath());
+    if (it == m_Saves.cend() || it->Size != file.size() ||
+        it->LastModified != file.lastModified().toMSecsSinceEpoch()) {
+      changed.push_back(file);
+    }
+  }
+
+  Changes changes;
+  QSet<QString> present(order.begin(), order.end());
+  for (auto it = m_Saves.begin(); it != m_Saves.end();) {
+    if (!present.contains(it.key())) {
+      changes.Removed.push_back(it.key());
+      removeFromGroup(it->Save);
+      it = m_Saves.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (!changed.isEmpty()) {
+    auto saves = m_Game->loadSaveGames(m_Folder, changed, files, report);
+    for (qsizetype i = 0; i < changed.size(); ++i) {
+      auto previous = m_Saves.constFind(changed[i].filePath());
+      if (previous != m_Saves.cend()) {
+        removeFromGroup(previous->Save);
+      }
+      addToGroup(saves[i]);
+
+      // files that failed to parse are kept with a null save so that they are
+      // not parsed again until they change
+      m_Saves.insert(changed[i].filePath(),
+                     Slot{changed[i].size(),
+                          changed[i].lastModified().toMSecsSinceEpoch(),
+                          std::move(saves[i])});
+      changes.Updated.push_back(changed[i].filePath());
+    }
+  }
+
+  m_Order = std::move(order);
+
+  // co-saves can come and go without their save changing
+  const bool hasScriptExtender =
+      m_Game->m_Organizer->gameFeatures()->gameFeature<MOBase::ScriptExtender>() !=
+      nullptr;
+  for (auto& file : files) {
+    auto it = m_Saves.constFind(file.filePath());
+    if (it != m_Saves.cend() && it->Save) {
+      it->Save->setScriptExtenderFile(
+          coSaves.contains(file.completeBaseName().toLower()), hasScriptExtender);
+    }
+  }
+
+  return changes;
+}
+
+void GamebryoSaveGameIndex::addToGroup(
+    std::shared_ptr<const GamebryoSaveGame> const& save)
+{
+  if (!save) {
+    return;
+  }
+  Group& group = m_Groups[save->getSaveGroupIdentifier()];
+  group.insert(std::upper_bound(group.begin(), group.end(), save, olderThan), save);
+}
+
+void GamebryoSaveGameIndex::removeFromGroup(
+    std::shared_ptr<const GamebryoSaveGame> const& save)
+{
+  if (!save) {
+    return;
+  }
+  auto it = m_Groups.find(save->getSaveGroupIdentifier());
+  if (it == m_Groups.end()) {
+    return;
+  }
+
+  // only the saves that compare equal need to be looked at
+  Group& group = it.value();
+  auto range   = std::equal_range(group.begin(), group.end(), save, olderThan);
+  auto found   = std::find(range.first, range.second, save);
+  if (found != range.second) {
+    group.erase(found);
+  }
+  if (group.empty()) {
+    m_Groups.erase(it);
+  }
+}
+
+void GamebryoSaveGameIndex::onDirectoryChanged()
+{
+  m_Debounce.start();
+}
@@ -0,0 +1,139 @@
+#ifndef GAMEBRYOSAVEGAMEINDEX_H
+#define GAMEBRYOSAVEGAMEINDEX_H
+
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "gamebryosavestats.h"
+
+class GameGamebryo;
+class GamebryoSaveGame;
+
+/**
+ * @brief Incremental index of the saves in a directory.
+ *
+ * The index keeps the parsed saves between listings and only parses the files
+ * that were added or modified since the last refresh, dropping the deleted
+ * ones. Every listing refreshes it, which only lists the directory when nothing
+ * changed. The directory is also watched so that changes are reported through
+ * savesChanged() without waiting for the next listing, once per burst.
+ *
+ * The saves are also grouped by character (getSaveGroupIdentifier()), each
+ * group sorted from oldest to newest, so that the saves of a character are
+ * found without going through the whole directory.
+ *
+ * The index can be used from any thread, one refresh at a time, while the watcher
+ * and its timer live on the thread of the index, which needs an event loop for the
+ * changes to be reported ahead of the next call.
+ */
+class GamebryoSaveGameIndex : public QObject
+{
+  Q_OBJECT
+
+public:
+  // delay after the last change in the directory before refreshing, so that
+  // e.g. an autosave rotation writing several files only refreshes once
+  static constexpr int DEBOUNCE_MS = 500;
+
+  GamebryoSaveGameIndex(GameGamebryo const* game, QDir const& folder);
+
+  QDir const& folder() const { return m_Folder; }
+
+  /**
+   * @return the saves in the directory, in directory order, refreshing the
+   *     index first.
+   *
+   * @param report If not null, the saves loaded by the refresh are added to it.
+   */
+  std::vector<std::shared_ptr<const GamebryoSaveGame>>
+  saves(GamebryoSaveStats::Report* report = nullptr);
+
+  using Group = std::vector<std::shared_ptr<const GamebryoSaveGame>>;
+
+  /**
+   * @return the identifiers of the groups, in no particular order, refreshing
+   *     the index first.
+   */
+  QStringList groups();
+
+  /**
+   * @return the saves of the given group, from oldest to newest by save number
+   *     then creation time, refreshing the index first.
+   */
+  Group group(QString const& identifier);
+
+  /**
+   * @return the saves of the given group except the newest `keep` ones, from
+   *     oldest to newest, e.g. to clean up old saves of a character.
+   */
+  Group allButNewest(QString const& identifier, std::size_t keep);
+
+  /**
+   * @brief Bring the index up to date with the directory.
+   */
+  void refresh();
+
+signals:
+  /**
+   * @brief Emitted after a refresh that changed the index.
+   *
+   * @param updated Paths of the saves that were added or modified.
+   * @param removed Paths of the saves that were deleted.
+   */
+  void savesChanged(QStringList const& updated, QStringList const& removed);
+
+private:
+  struct Changes
+  {
+    QStringList Updated;
+    QStringList Removed;
+  };
+
+  // refresh with the mutex held, the changes are only emitted once it is released
+  // since the slots may call the index
+  Changes update(GamebryoSaveStats::Report* report);
+  void notify(Changes const& changes);
+
+  void onDirectoryChanged();
+
+  void addToGroup(std::shared_ptr<const GamebryoSaveGame> const& save);
+  void removeFromGroup(std::shared_ptr<const GamebryoSaveGame> const& save);
+
+private:
+  struct Slot
+  {
+    qint64 Size;
+    qint64 LastModified;
+    std::shared_ptr<const GamebryoSaveGame> Save;
+  };
+
+  GameGamebryo const* m_Game;
+  QDir m_Folder;
+
+  // guards everything below but the watcher and the timer
+  std::mutex m_Mutex;
+
+  // file paths in directory order, and the corresponding parsed saves
+  QStringList m_Order;
+  QHash<QString, Slot> m_Saves;
+
+  // the parsed saves above by group identifier, see group()
+  QHash<QString, Group> m_Groups;
+
+  // only used to refresh, and thus emit savesChanged(), ahead of the next call,
+  // the watcher does not report files rewritten in place, children of the index so
+  // that they follow it to its thread
+  QFileSystemWatcher m_Watcher;
+  QTimer m_Debounce;
+};
+
+#endif  // GAMEBRYOSAVEGAMEINDEX_H
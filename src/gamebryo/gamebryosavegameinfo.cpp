@@ -1,17 +1,40 @@
 #include "gamebryosavegameinfo.h"
 
+#include "gamebryopluginproviders.h"
 #include "gamebryosavegame.h"
 #include "gamebryosavegameinfowidget.h"
 #include "gamegamebryo.h"
-#include "imodinterface.h"
 #include "imoinfo.h"
-#include "iplugingame.h"
 #include "ipluginlist.h"
+#include "log.h"
 
-#include <QDir>
 #include <QString>
 #include <QStringList>
 
+#include <cstdint>
+
+namespace
+{
+// set of plugin ids, which are small and dense
+class PluginIdSet
+{
+public:
+  explicit PluginIdSet(std::size_t size) : m_Words((size + 63) / 64) {}
+
+  void insert(GamebryoPluginNames::Id id) { m_Words[id / 64] |= bit(id); }
+
+  bool contains(GamebryoPluginNames::Id id) const
+  {
+    return id / 64 < m_Words.size() && (m_Words[id / 64] & bit(id)) != 0;
+  }
+
+private:
+  static uint64_t bit(GamebryoPluginNames::Id id) { return uint64_t(1) << (id % 64); }
+
+  std::vector<uint64_t> m_Words;
+};
+}  // namespace
+
 GamebryoSaveGameInfo::GamebryoSaveGameInfo(GameGamebryo const* game) : m_Game(game) {}
 
 GamebryoSaveGameInfo::~GamebryoSaveGameInfo() {}
@@ -21,12 +44,13 @@ GamebryoSaveGameInfo::getMissingAssets(MOBase::ISaveGame const& save) const
 {
   GamebryoSaveGame const& gamebryoSave = dynamic_cast<GamebryoSaveGame const&>(save);
   MOBase::IOrganizer* organizerCore    = m_Game->m_Organizer;
+  auto states                          = pluginStates();
 
   // collect the list of missing plugins
   MissingAssets missingAssets;
 
   for (QString const& pluginName : gamebryoSave.getPlugins()) {
-    switch (organizerCore->pluginList()->state(pluginName)) {
+    switch (states->state(pluginName)) {
     case MOBase::IPluginList::STATE_INACTIVE:
       missingAssets[pluginName] =
           ProvidingModules{organizerCore->pluginList()->origin(pluginName)};
@@ -38,7 +62,7 @@ GamebryoSaveGameInfo::getMissingAssets(MOBase::ISaveGame const& save) const
   }
 
   for (QString const& pluginName : gamebryoSave.getLightPlugins()) {
-    switch (organizerCore->pluginList()->state(pluginName)) {
+    switch (states->state(pluginName)) {
     case MOBase::IPluginList::STATE_INACTIVE:
       missingAssets[pluginName] =
           ProvidingModules{organizerCore->pluginList()->origin(pluginName)};
@@ -49,48 +73,114 @@ GamebryoSaveGameInfo::getMissingAssets(MOBase::ISaveGame const& save) const
     }
   }
 
-  // Find out any other mods that might contain the esp/esm
-  QStringList espFilter({"*.esp", "*.esl", "*.esm"});
-
-  QString dataDir(organizerCore->managedGame()->dataDirectory().absolutePath());
-
-  // Search normal mods. A note: This will also find mods in data.
-  for (QString const& mod : organizerCore->modList()->allModsByProfilePriority()) {
-    MOBase::IModInterface* modInfo = organizerCore->modList()->getMod(mod);
-    QStringList esps               = QDir(modInfo->absolutePath()).entryList(espFilter);
-    for (QString const& esp : esps) {
-      MissingAssets::iterator iter = missingAssets.find(esp);
-      if (modInfo->absolutePath() == dataDir) {
-        // We have to prune esps that reside in the data directory, otherwise
-        // you get all the unmanaged mods listed as potential candidates for
-        // enabling
-        if (modInfo->name() != organizerCore->pluginList()->origin(esp)) {
-          continue;
-        }
-      }
-      if (iter != missingAssets.end()) {
-        if (!iter->contains(modInfo->name())) {
-          iter->push_back(modInfo->name());
-        }
+  // Find out any other mods that might contain the esp/esm, and the overwrite
+  for (auto iter = missingAssets.begin(); iter != missingAssets.end(); ++iter) {
+    for (QString const& mod : providers().providers(iter.key())) {
+      if (!iter->contains(mod)) {
+        iter->push_back(mod);
       }
     }
   }
 
-  // search in overwrite
-  {
-    QDir overwriteDir(organizerCore->overwritePath());
-    QStringList esps = overwriteDir.entryList(espFilter);
-    for (const QString& esp : esps) {
-      MissingAssets::iterator iter = missingAssets.find(esp);
-      if (iter != missingAssets.end()) {
-        if (!iter->contains("<overwrite>")) {
-          iter->push_back("<overwrite>");
-        }
+  return missingAssets;
+}
+
+void GamebryoSaveGameInfo::createIndexes() const
+{
+  std::call_once(m_IndexesOnce, [this] {
+    m_Providers    = std::make_unique<GamebryoPluginProviders>(m_Game->m_Organizer);
+    m_PluginStates = std::make_unique<GamebryoPluginStates>(m_Game->m_Organizer);
+  });
+}
+
+GamebryoPluginProviders const& GamebryoSaveGameInfo::providers() const
+{
+  createIndexes();
+  return *m_Providers;
+}
+
+std::shared_ptr<const GamebryoPluginStates::Snapshot>
+GamebryoSaveGameInfo::pluginStates() const
+{
+  createIndexes();
+  return m_PluginStates->snapshot();
+}
+
+std::vector<GamebryoSaveGameInfo::SaveAssets>
+GamebryoSaveGameInfo::getSavesMissingAssets(
+    std::vector<std::shared_ptr<const GamebryoSaveGame>> const& saves) const
+{
+  std::vector<SaveAssets> assets(saves.size());
+
+  auto read = [&](std::size_t i) {
+    if (!saves[i]) {
+      assets[i].Read = false;
+      return;
+    }
+    try {
+      saves[i]->getPluginIds();
+    } catch (std::exception& e) {
+      MOBase::log::error("{}", e.what());
+      assets[i].Read = false;
+    }
+  };
+
+  // the plugins of the saves that are not loaded yet are read first, this is
+  // where the time goes, with as many threads as the game parses saves with
+  m_Game->forEachConcurrently(saves.size(), m_Game->saveListConcurrency(), read);
+
+  // the state of every distinct plugin of the saves, the snapshot is taken on
+  // this thread
+  const std::size_t size = GamebryoPluginNames::instance().size();
+  PluginIdSet seen(size), missing(size), inactive(size);
+
+  auto states = pluginStates();
+  auto evaluate = [&](QStringList const& names, auto const& ids) {
+    for (std::size_t j = 0; j < ids.size(); ++j) {
+      if (seen.contains(ids[j])) {
+        continue;
+      }
+      seen.insert(ids[j]);
+      switch (states->state(names[j])) {
+      case MOBase::IPluginList::STATE_INACTIVE:
+        inactive.insert(ids[j]);
+        break;
+      case MOBase::IPluginList::STATE_MISSING:
+        missing.insert(ids[j]);
+        break;
       }
     }
+  };
+  for (std::size_t i = 0; i < saves.size(); ++i) {
+    if (assets[i].Read) {
+      evaluate(saves[i]->getPlugins(), saves[i]->getPluginIds());
+      evaluate(saves[i]->getMediumPlugins(), saves[i]->getMediumPluginIds());
+      evaluate(saves[i]->getLightPlugins(), saves[i]->getLightPluginIds());
+    }
   }
 
-  return missingAssets;
+  auto collect = [&](std::size_t i) {
+    if (!assets[i].Read) {
+      return;
+    }
+    auto check = [&](QStringList const& names, auto const& ids) {
+      for (std::size_t j = 0; j < ids.size(); ++j) {
+        if (missing.contains(ids[j])) {
+          assets[i].Missing.append(names[j]);
+        } else if (inactive.contains(ids[j])) {
+          assets[i].Inactive.append(names[j]);
+        }
+      }
+    };
+    check(saves[i]->getPlugins(), saves[i]->getPluginIds());
+    check(saves[i]->getMediumPlugins(), saves[i]->getMediumPluginIds());
+    check(saves[i]->getLightPlugins(), saves[i]->getLightPluginIds());
+  };
+
+  // only reads what is built above, so on every core
+  m_Game->forEachConcurrently(saves.size(), 0, collect);
+
+  return assets;
 }
 
 MOBase::ISaveGameInfoWidget*
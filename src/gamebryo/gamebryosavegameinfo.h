@@ -1,9 +1,18 @@
 #ifndef GAMEBRYOSAVEGAMEINFO_H
 #define GAMEBRYOSAVEGAMEINFO_H
 
+#include "gamebryopluginstates.h"
 #include "savegameinfo.h"
 
+#include <QStringList>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
 class GameGamebryo;
+class GamebryoPluginProviders;
+class GamebryoSaveGame;
 
 class GamebryoSaveGameInfo : public MOBase::SaveGameInfo
 {
@@ -15,9 +24,49 @@ public:
 
   virtual MOBase::ISaveGameInfoWidget* getSaveGameWidget(QWidget*) const override;
 
+  /**
+   * @brief Plugins of a save that are not active in the current profile.
+   */
+  struct SaveAssets
+  {
+    QStringList Missing;
+    QStringList Inactive;
+
+    // false if the plugins of the save could not be read
+    bool Read = true;
+
+    bool loadable() const { return Read && Missing.isEmpty() && Inactive.isEmpty(); }
+  };
+
+  /**
+   * @brief Find the missing and inactive plugins, including the medium and light
+   *     ones, of many saves at once, e.g. to only show the loadable ones.
+   *
+   * The state of each plugin is asked once for all the saves, on this thread,
+   * and the saves are read and checked concurrently. The mods providing the
+   * plugins are not looked up, see getMissingAssets() for that.
+   *
+   * @return one entry per save, in the same order, null saves are not read.
+   */
+  std::vector<SaveAssets> getSavesMissingAssets(
+      std::vector<std::shared_ptr<const GamebryoSaveGame>> const& saves) const;
+
 protected:
   friend class GamebryoSaveGameInfoWidget;
   GameGamebryo const* m_Game;
+
+  // states of the plugins in the current plugin list, taken again only when it
+  // changes
+  std::shared_ptr<const GamebryoPluginStates::Snapshot> pluginStates() const;
+
+private:
+  // built on the first query, the organizer is not set up before
+  void createIndexes() const;
+  GamebryoPluginProviders const& providers() const;
+
+  mutable std::once_flag m_IndexesOnce;
+  mutable std::unique_ptr<GamebryoPluginProviders> m_Providers;
+  mutable std::unique_ptr<GamebryoPluginStates> m_PluginStates;
 };
 
 #endif  // GAMEBRYOSAVEGAMEINFO_H
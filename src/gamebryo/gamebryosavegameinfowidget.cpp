@@ -15,6 +15,7 @@
 #include <QLayout>
 #include <QLayoutItem>
 #include <QPixmap>
+#include <QPointer>
 #include <QString>
 #include <QStyle>
 #include <QTime>
@@ -50,6 +51,27 @@ GamebryoSaveGameInfoWidget::~GamebryoSaveGameInfoWidget()
 void GamebryoSaveGameInfoWidget::setSave(MOBase::ISaveGame const& save)
 {
   auto& gamebryoSave = dynamic_cast<GamebryoSaveGame const&>(save);
+
+  auto shared = gamebryoSave.weak_from_this().lock();
+  if (!shared || shared != m_Save.lock()) {
+    m_Save          = shared;
+    m_LoadRequested = false;
+    m_LoadFailed    = false;
+  }
+
+  // saves that are not shared cannot be loaded in the background
+  if (!shared) {
+    try {
+      gamebryoSave.getPlugins();
+    } catch (std::exception&) {
+      m_LoadFailed = true;
+    }
+  }
+
+  // the plugins and the screenshot are not loaded here, a save that does not have
+  // them yet shows a placeholder until they are
+  const QString pending = m_LoadFailed ? tr("Unavailable") : tr("Loading...");
+
   ui->saveNumLabel->setText(QString("%1").arg(gamebryoSave.getSaveNumber()));
   ui->characterLabel->setText(gamebryoSave.getPCName());
   ui->locationLabel->setText(gamebryoSave.getPCLocation());
@@ -60,7 +82,11 @@ void GamebryoSaveGameInfoWidget::setSave(MOBase::ISaveGame const& save)
   ui->dateLabel->setText(
       QLocale::system().toString(t.date(), QLocale::FormatType::ShortFormat) + " " +
       QLocale::system().toString(t.time()));
-  ui->screenshotLabel->setPixmap(QPixmap::fromImage(gamebryoSave.getScreenshot()));
+  if (QImage const* screenshot = gamebryoSave.tryGetScreenshot()) {
+    ui->screenshotLabel->setPixmap(QPixmap::fromImage(*screenshot));
+  } else {
+    ui->screenshotLabel->setText(pending);
+  }
   if (ui->gameFrame->layout() != nullptr) {
     QLayoutItem* item = nullptr;
     while ((item = ui->gameFrame->layout()->takeAt(0)) != nullptr) {
@@ -88,10 +114,12 @@ void GamebryoSaveGameInfoWidget::setSave(MOBase::ISaveGame const& save)
   contentFont.setPointSize(7);
   header->setFont(headerFont);
   layout->addWidget(header);
-  int count                       = 0;
-  MOBase::IPluginList* pluginList = m_Info->m_Game->m_Organizer->pluginList();
-  for (QString const& pluginName : gamebryoSave.getPlugins()) {
-    if (pluginList->state(pluginName) == MOBase::IPluginList::STATE_ACTIVE) {
+  int count   = 0;
+  auto states = m_Info->pluginStates();
+
+  QStringList const* plugins = gamebryoSave.tryGetPlugins();
+  for (QString const& pluginName : plugins ? *plugins : QStringList()) {
+    if (states->state(pluginName) == MOBase::IPluginList::STATE_ACTIVE) {
       continue;
     }
 
@@ -113,7 +141,7 @@ void GamebryoSaveGameInfoWidget::setSave(MOBase::ISaveGame const& save)
     layout->addWidget(dotDotLabel);
   }
   if (count == 0) {
-    QLabel* dotDotLabel = new QLabel(tr("None"));
+    QLabel* dotDotLabel = new QLabel(plugins ? tr("None") : pending);
     dotDotLabel->setIndent(10);
     dotDotLabel->setFont(contentFont);
     layout->addWidget(dotDotLabel);
@@ -128,8 +156,10 @@ void GamebryoSaveGameInfoWidget::setSave(MOBase::ISaveGame const& save)
     headerEsh->setFont(headerEshFont);
     layout->addWidget(headerEsh);
     int countEsh = 0;
-    for (QString const& pluginName : gamebryoSave.getMediumPlugins()) {
-      if (pluginList->state(pluginName) == MOBase::IPluginList::STATE_ACTIVE) {
+
+    QStringList const* mediumPlugins = gamebryoSave.tryGetMediumPlugins();
+    for (QString const& pluginName : mediumPlugins ? *mediumPlugins : QStringList()) {
+      if (states->state(pluginName) == MOBase::IPluginList::STATE_ACTIVE) {
         continue;
       }
 
@@ -151,7 +181,7 @@ void GamebryoSaveGameInfoWidget::setSave(MOBase::ISaveGame const& save)
       layout->addWidget(dotDotLabel);
     }
     if (countEsh == 0) {
-      QLabel* dotDotLabel = new QLabel(tr("None"));
+      QLabel* dotDotLabel = new QLabel(mediumPlugins ? tr("None") : pending);
       dotDotLabel->setIndent(10);
       dotDotLabel->setFont(contentFont);
       layout->addWidget(dotDotLabel);
@@ -167,8 +197,10 @@ void GamebryoSaveGameInfoWidget::setSave(MOBase::ISaveGame const& save)
     headerEsl->setFont(headerEslFont);
     layout->addWidget(headerEsl);
     int countEsl = 0;
-    for (QString const& pluginName : gamebryoSave.getLightPlugins()) {
-      if (pluginList->state(pluginName) == MOBase::IPluginList::STATE_ACTIVE) {
+
+    QStringList const* lightPlugins = gamebryoSave.tryGetLightPlugins();
+    for (QString const& pluginName : lightPlugins ? *lightPlugins : QStringList()) {
+      if (states->state(pluginName) == MOBase::IPluginList::STATE_ACTIVE) {
         continue;
       }
 
@@ -190,10 +222,29 @@ void GamebryoSaveGameInfoWidget::setSave(MOBase::ISaveGame const& save)
       layout->addWidget(dotDotLabel);
     }
     if (countEsl == 0) {
-      QLabel* dotDotLabel = new QLabel(tr("None"));
+      QLabel* dotDotLabel = new QLabel(lightPlugins ? tr("None") : pending);
       dotDotLabel->setIndent(10);
       dotDotLabel->setFont(contentFont);
       layout->addWidget(dotDotLabel);
     }
   }
+
+  if (!shared || m_LoadRequested ||
+      gamebryoSave.dataFieldsStatus() == GamebryoSaveGame::DataFieldsStatus::READY) {
+    return;
+  }
+
+  m_LoadRequested = true;
+
+  QPointer<GamebryoSaveGameInfoWidget> self  = this;
+  std::weak_ptr<const GamebryoSaveGame> weak = shared;
+  GamebryoSaveGame::loadDataFieldsAsync(shared, [self, weak](bool loaded) {
+    // the widget may have moved on to another save in between
+    auto save = weak.lock();
+    if (!self || !save || save != self->m_Save.lock()) {
+      return;
+    }
+    self->m_LoadFailed = !loaded;
+    self->setSave(*save);
+  });
 }
@@ -5,6 +5,9 @@
 
 #include <QObject>
 
+#include <memory>
+
+class GamebryoSaveGame;
 class GamebryoSaveGameInfo;
 
 namespace Ui
@@ -25,6 +28,12 @@ public:
 private:
   Ui::GamebryoSaveGameInfoWidget* ui;
   GamebryoSaveGameInfo const* m_Info;
+
+  // save being shown, whose plugins and screenshot are loaded in the background if
+  // they are not yet, the widget being filled again once they are
+  std::weak_ptr<const GamebryoSaveGame> m_Save;
+  bool m_LoadRequested = false;
+  bool m_LoadFailed    = false;
 };
 
 #endif  // GAMEBRYOSAVEGAMEINFOWIDGET_H
@@ -2,8 +2,11 @@
 
 #include "bsainvalidation.h"
 #include "dataarchives.h"
+#include "gamebryobatchreader.h"
 #include "gamebryomoddatacontent.h"
 #include "gamebryosavegame.h"
+#include "gamebryosavegamecache.h"
+#include "gamebryosavegameindex.h"
 #include "gameplugins.h"
 #include "iprofile.h"
 #include "log.h"
@@ -16,11 +19,14 @@
 
 #include <QDir>
 #include <QDirIterator>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QIcon>
 #include <QJsonDocument>
 #include <QJsonValue>
+#include <QSemaphore>
+#include <QThread>
 
 #include <QtDebug>
 #include <QtGlobal>
@@ -31,11 +37,26 @@
 #include <winreg.h>
 #include <winver.h>
 
+#include <algorithm>
+#include <atomic>
 #include <optional>
 #include <string>
 #include <vector>
 
-GameGamebryo::GameGamebryo() {}
+GameGamebryo::GameGamebryo()
+{
+  m_PrefetchPool.setMaxThreadCount(2);
+}
+
+GameGamebryo::~GameGamebryo()
+{
+  // the prefetch tasks parse saves through this game, so wait for the running
+  // ones before the plugin is unloaded
+  GamebryoSaveGame::cancelPrefetch();
+  m_PrefetchPool.clear();
+  m_PrefetchPool.waitForDone();
+  m_WorkerPool.waitForDone();
+}
 
 void GameGamebryo::detectGame()
 {
@@ -90,22 +111,305 @@ QDir GameGamebryo::savesDirectory() const
 std::vector<std::shared_ptr<const MOBase::ISaveGame>>
 GameGamebryo::listSaves(QDir folder) const
 {
-  QStringList filters;
-  filters << QString("*.") + savegameExtension();
+  // the index is only replaced under the lock, a listing of the previous folder
+  // that is still running keeps its own reference
+  std::shared_ptr<GamebryoSaveGameIndex> index;
+  {
+    std::lock_guard lock(m_SaveIndexMutex);
+    if (!m_SaveIndex || m_SaveIndex->folder() != folder) {
+      // the watcher and the timer of the index need the event loop of the game's
+      // thread, whichever thread lists the saves, and must be destroyed there
+      auto* created = new GamebryoSaveGameIndex(this, folder);
+      created->moveToThread(thread());
+      m_SaveIndex.reset(created, [](GamebryoSaveGameIndex* index) {
+        if (index->thread() == QThread::currentThread()) {
+          delete index;
+        } else {
+          index->deleteLater();
+        }
+      });
+    }
+    index = m_SaveIndex;
+  }
+
+  // only what this listing loads is reported, not the refreshes of the index
+  // that run in between
+  std::optional<GamebryoSaveStats::Report> report;
+  QElapsedTimer elapsed;
+  if (m_SaveStats) {
+    report.emplace();
+    elapsed.start();
+  }
+  auto indexed = index->saves(report ? &*report : nullptr);
+
+  if (report) {
+    report->WallNanoseconds = elapsed.nsecsElapsed();
+    report->Listed          = indexed.size();
+    report->IndexHits =
+        report->Listed - report->CacheHits - (report->Saves.size() - report->Failed);
+    MOBase::log::debug("{}", report->summary());
+
+    std::lock_guard lock(m_SaveIndexMutex);
+    m_LastSaveScan = std::move(*report);
+  }
+
+  // load the plugins and screenshots of the newest saves ahead of their tooltips,
+  // in the order they are listed, newest first, the others are loaded on demand
+  auto newest = indexed;
+  const auto prefetched = std::min<std::size_t>(newest.size(), SAVE_PREFETCH_COUNT);
+  std::partial_sort(newest.begin(), newest.begin() + prefetched, newest.end(),
+                    [](auto const& a, auto const& b) {
+                      return a->getCreationTime() > b->getCreationTime();
+                    });
+  newest.resize(prefetched);
+  GamebryoSaveGame::prefetchDataFields(newest);
 
   std::vector<std::shared_ptr<const MOBase::ISaveGame>> saves;
-  for (auto info : folder.entryInfoList(filters, QDir::Files)) {
+  for (auto& save : indexed) {
+    saves.push_back(std::move(save));
+  }
+
+  return saves;
+}
+
+std::vector<std::shared_ptr<const GamebryoSaveGame>>
+GameGamebryo::loadSaveGames(QDir const& folder, QFileInfoList const& files,
+                            QFileInfoList const& all,
+                            GamebryoSaveStats::Report* report) const
+{
+  // cached saves are created from their header, so the cache is neither read nor
+  // written for games that cannot do it, which a header without a file is enough
+  // to tell
+  bool useCache = false;
+  if (m_SaveGameCache) {
+    std::call_once(m_HeaderSavesChecked, [this] {
+      m_HeaderSaves = makeSaveGame(QString(), GamebryoSaveHeader()) != nullptr;
+    });
+    useCache = m_HeaderSaves;
+  }
+
+  GamebryoSaveGameCache cache(folder);
+  if (useCache) {
+    cache.load();
+  }
+
+  // serve unchanged saves from the cache and only parse the others
+  std::vector<std::shared_ptr<const GamebryoSaveGame>> saves(files.size());
+  std::vector<qsizetype> missing;
+  QStringList filepaths;
+  for (qsizetype i = 0; i < files.size(); ++i) {
+    if (auto entry = cache.find(files[i])) {
+      saves[i] = makeSaveGame(files[i].filePath(), entry->Header);
+    }
+    if (!saves[i]) {
+      missing.push_back(i);
+      filepaths.push_back(files[i].filePath());
+    }
+  }
+  if (report != nullptr) {
+    report->CacheHits += files.size() - missing.size();
+  }
+
+  auto parsed = makeSaveGames(filepaths, report);
+  for (std::size_t i = 0; i < missing.size(); ++i) {
+    if (parsed[i]) {
+      if (useCache) {
+        cache.insert(files[missing[i]], *parsed[i]);
+      }
+      saves[missing[i]] = std::move(parsed[i]);
+    }
+  }
+
+  if (useCache) {
+    cache.prune(all);
+    cache.save();
+  }
+
+  return saves;
+}
+
+std::vector<std::shared_ptr<const GamebryoSaveGame>>
+GameGamebryo::makeSaveGames(QStringList const& filepaths,
+                            GamebryoSaveStats::Report* report) const
+{
+  // one slot per file so the output keeps the order of the input
+  std::vector<std::shared_ptr<const GamebryoSaveGame>> saves(filepaths.size());
+
+  std::vector<GamebryoSaveStats::Record> records;
+  if (report != nullptr) {
+    records.resize(filepaths.size());
+  }
+
+  const bool probe = supportsHeaderProbe();
+
+  auto parse = [&](qsizetype i) {
+    std::optional<GamebryoSaveStats::Scope> scope;
+    if (report != nullptr) {
+      records[i].File = filepaths[i];
+      scope.emplace(records[i]);
+    }
     try {
-      saves.push_back(makeSaveGame(info.filePath()));
+      // only the header is needed to list the save
+      if (probe) {
+        std::optional<GamebryoSaveHeader> header;
+        try {
+          header = probeSaveHeader(filepaths[i]);
+        } catch (std::exception&) {
+          // parse the whole save instead, which reports the error if any
+        }
+        if (header) {
+          saves[i] = makeSaveGame(filepaths[i], *header);
+        }
+      }
+
+      if (!saves[i]) {
+        saves[i] = makeSaveGame(filepaths[i]);
+      }
     } catch (std::exception& e) {
       MOBase::log::error("{}", e.what());
-      continue;
+      saves[i] = nullptr;
+    }
+  };
+
+  // when probing, the headers of all the files are read ahead in the background
+  // and the saves are parsed in the order the reads complete, each call taking
+  // the next read so that there is one call per file
+  std::optional<GamebryoBatchReader> reader;
+  if (probe && m_SaveListIoDepth > 0) {
+    reader.emplace(filepaths, GamebryoSaveFile::PROBE_SIZE, m_SaveListIoDepth);
+  }
+
+  auto parseNext = [&](std::size_t i) {
+    if (!reader) {
+      parse(i);
+      return;
+    }
+    GamebryoBatchReader::Completion read;
+    if (reader->next(read)) {
+      std::optional<GamebryoSaveFile::Prefetched> prefetched;
+      if (read.Ok) {
+        prefetched.emplace(filepaths[read.Index], read.Data);
+      }
+      parse(read.Index);
+    }
+  };
+
+  // workers pick the next file until there is none left, so a slow file does
+  // not hold back the others
+  forEachConcurrently(filepaths.size(), m_SaveListConcurrency, parseNext);
+
+  if (report != nullptr) {
+    for (std::size_t i = 0; i < saves.size(); ++i) {
+      report->Saves.push_back(std::move(records[i]));
+      if (!saves[i]) {
+        ++report->Failed;
+      }
     }
   }
 
   return saves;
 }
 
+void GameGamebryo::forEachConcurrently(
+    std::size_t count, int threads, std::function<void(std::size_t)> const& fn) const
+{
+  const int wanted          = threads > 0 ? threads : QThread::idealThreadCount();
+  const std::size_t workers = std::min<std::size_t>(std::max(wanted, 1), count);
+
+  std::atomic<std::size_t> next = 0;
+
+  auto work = [&] {
+    for (std::size_t i = next++; i < count; i = next++) {
+      fn(i);
+    }
+  };
+
+  // tasks that do not get a thread right away are not queued, the others are
+  // enough to go through the whole range
+  QSemaphore done;
+  int started = 0;
+  for (std::size_t t = 1; t < workers; ++t) {
+    if (!m_WorkerPool.tryStart([&] {
+          work();
+          done.release();
+        })) {
+      break;
+    }
+    ++started;
+  }
+
+  work();
+  done.acquire(started);
+}
+
+bool GameGamebryo::supportsHeaderProbe() const
+{
+  return false;
+}
+
+std::shared_ptr<const GamebryoSaveGame>
+GameGamebryo::makeSaveGame(QString, GamebryoSaveHeader const&) const
+{
+  return nullptr;
+}
+
+std::optional<GamebryoSaveHeader> GameGamebryo::probeSaveHeader(QString const&) const
+{
+  return {};
+}
+
+void GameGamebryo::setSaveListConcurrency(int threads)
+{
+  m_SaveListConcurrency = threads;
+}
+
+int GameGamebryo::saveListConcurrency() const
+{
+  return m_SaveListConcurrency;
+}
+
+void GameGamebryo::setSaveListIoDepth(int depth)
+{
+  m_SaveListIoDepth = depth;
+}
+
+int GameGamebryo::saveListIoDepth() const
+{
+  return m_SaveListIoDepth;
+}
+
+void GameGamebryo::setSaveGameCacheEnabled(bool enabled)
+{
+  m_SaveGameCache = enabled;
+}
+
+bool GameGamebryo::saveGameCacheEnabled() const
+{
+  return m_SaveGameCache;
+}
+
+void GameGamebryo::setSaveStatsEnabled(bool enabled)
+{
+  m_SaveStats = enabled;
+}
+
+bool GameGamebryo::saveStatsEnabled() const
+{
+  return m_SaveStats;
+}
+
+GamebryoSaveStats::Report GameGamebryo::lastSaveScanReport() const
+{
+  std::lock_guard lock(m_SaveIndexMutex);
+  return m_LastSaveScan;
+}
+
+std::shared_ptr<GamebryoSaveGameIndex> GameGamebryo::saveGameIndex() const
+{
+  std::lock_guard lock(m_SaveIndexMutex);
+  return m_SaveIndex;
+}
+
 void GameGamebryo::setGameVariant(const QString& variant)
 {
   m_GameVariant = variant;
@@ -12,16 +12,23 @@ class LocalSavegames;
 class ScriptExtender;
 class GamePlugins;
 class UnmanagedMods;
+class GamebryoSaveGameIndex;
 
 #include <QObject>
 #include <QString>
+#include <QThreadPool>
 #include <ShlObj.h>
 #include <dbghelp.h>
 #include <ipluginfilemapper.h>
 #include <iplugingame.h>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 
 #include "gamebryosavegame.h"
+#include "gamebryosaveheader.h"
+#include "gamebryosavestats.h"
 #include "igamefeatures.h"
 
 class GameGamebryo : public MOBase::IPluginGame, public MOBase::IPluginFileMapper
@@ -33,6 +40,7 @@ class GameGamebryo : public MOBase::IPluginGame, public MOBase::IPluginFileMappe
   friend class GamebryoSaveGameInfo;
   friend class GamebryoSaveGameInfoWidget;
   friend class GamebryoSaveGame;
+  friend class GamebryoSaveGameIndex;
 
   /**
    * Some Bethesda games do not have a valid file version but a valid product
@@ -41,8 +49,13 @@ class GameGamebryo : public MOBase::IPluginGame, public MOBase::IPluginFileMappe
    */
   static constexpr const char* FALLBACK_GAME_VERSION = "1.0.0";
 
+  // Number of saves whose data fields listSaves() loads in the background, the
+  // newest ones, since each of them keeps its screenshot in memory.
+  static constexpr std::size_t SAVE_PREFETCH_COUNT = 32;
+
 public:
   GameGamebryo();
+  ~GameGamebryo();
 
   void detectGame() override;
   bool init(MOBase::IOrganizer* moInfo) override;
@@ -88,15 +101,106 @@ public:  // IPluginFileMapper interface
 public:  // Other (e.g. for game features)
   QString myGamesPath() const;
 
+  // Maximum number of threads used to parse save headers in listSaves(), 0 uses
+  // one thread per core. The default, 1, parses them on the calling thread: games
+  // opt in once their makeSaveGame() and fetchDataFields() are safe to call from
+  // several threads at once.
+  void setSaveListConcurrency(int threads);
+  int saveListConcurrency() const;
+
+  // Number of header reads kept in flight by listSaves() for games that probe
+  // headers (see supportsHeaderProbe()), which hides the latency of slow disks and
+  // network shares, 0 reads each header on the thread parsing it.
+  void setSaveListIoDepth(int depth);
+  int saveListIoDepth() const;
+
+  // Whether listSaves() keeps the parsed headers in a cache file next to the saves
+  // directory, off by default. Cached saves are created by the game from their
+  // header, so the cache file is neither read nor written for games that do not
+  // implement makeSaveGame(filepath, header).
+  void setSaveGameCacheEnabled(bool enabled);
+  bool saveGameCacheEnabled() const;
+
+  // Whether listSaves() is timed, with the saves it parses timed stage by stage, in
+  // which case each call is summarized in the log and its report kept until the
+  // next one.
+  void setSaveStatsEnabled(bool enabled);
+  bool saveStatsEnabled() const;
+  GamebryoSaveStats::Report lastSaveScanReport() const;
+
+  // Index of the directory last listed by listSaves(), which groups its saves by
+  // character, or null if no directory has been listed yet. It stays valid when
+  // another directory is listed.
+  std::shared_ptr<GamebryoSaveGameIndex> saveGameIndex() const;
+
 protected:
   // Retrieve the saves extension for the game.
   virtual QString savegameExtension() const   = 0;
   virtual QString savegameSEExtension() const = 0;
 
   // Create a save game.
+  //
+  // This is called concurrently from multiple threads by listSaves() if the game
+  // enabled it, see setSaveListConcurrency().
   virtual std::shared_ptr<const GamebryoSaveGame>
   makeSaveGame(QString filepath) const = 0;
 
+  // Create a save game from header fields that are already known, from the save
+  // game cache or from probeSaveHeader(), without opening the file. The save is
+  // expected to be of the same type as the ones created above, and to parse the
+  // file when its data fields are needed, see the matching GamebryoSaveGame
+  // constructor. Returns null if the game cannot do this, which is the default,
+  // in which case the file is parsed by makeSaveGame(filepath) instead.
+  //
+  // This is called concurrently from multiple threads by listSaves() if the game
+  // enabled it, see setSaveListConcurrency().
+  virtual std::shared_ptr<const GamebryoSaveGame>
+  makeSaveGame(QString filepath, GamebryoSaveHeader const& header) const;
+
+  // Whether probeSaveHeader() and makeSaveGame(filepath, header) are implemented,
+  // in which case listSaves() probes the headers, reading them ahead if the game
+  // set an I/O depth. The default is false, and each save is parsed by
+  // makeSaveGame(filepath) without being probed first.
+  virtual bool supportsHeaderProbe() const;
+
+  // Read only the fields needed to list a save, typically with a GamebryoSaveFile
+  // opened with a prefix of GamebryoSaveFile::PROBE_SIZE bytes, so that the save
+  // is fully parsed only once its plugins or screenshot are needed. Returns
+  // nothing if the game cannot do this, which is the default, and may throw if the
+  // header does not fit.
+  //
+  // This is called concurrently from multiple threads by listSaves() if the game
+  // enabled it, see setSaveListConcurrency().
+  virtual std::optional<GamebryoSaveHeader>
+  probeSaveHeader(QString const& filepath) const;
+
+  // Create the save games for some of the files of a saves directory, going
+  // through the save game cache if it is enabled. `all` is the full listing of the
+  // directory, used to drop stale cache entries. The result is aligned with
+  // `files`, with null for files that could not be parsed. The cache hits and the
+  // saves that are parsed are added to the report, if any.
+  std::vector<std::shared_ptr<const GamebryoSaveGame>>
+  loadSaveGames(QDir const& folder, QFileInfoList const& files,
+                QFileInfoList const& all,
+                GamebryoSaveStats::Report* report = nullptr) const;
+
+  // Create the save games for the given files on a bounded pool of threads,
+  // keeping the order of the files. Files that cannot be parsed are logged and
+  // are null in the result.
+  //
+  // Each thread parses its share of the files one after the other, so they all
+  // reuse that thread's buffers and decompression state (see GamebryoSaveFile).
+  // The saves are added to the report, if any, with the failures counted.
+  std::vector<std::shared_ptr<const GamebryoSaveGame>>
+  makeSaveGames(QStringList const& filepaths,
+                GamebryoSaveStats::Report* report = nullptr) const;
+
+  // Call fn(i) for each i below count on up to `threads` threads, 0 for one per
+  // core, and return once all the calls have. The calling thread is one of them,
+  // the others come from the worker pool, and fewer are used if it is busy.
+  void forEachConcurrently(std::size_t count, int threads,
+                           std::function<void(std::size_t)> const& fn) const;
+
   QFileInfo findInGameFolder(const QString& relativePath) const;
   QString selectedVariant() const;
   WORD getArch(QString const& program) const;
@@ -146,6 +250,32 @@ protected:
   QString m_MyGamesPath;
   QString m_GameVariant;
   MOBase::IOrganizer* m_Organizer;
+  int m_SaveListConcurrency = 1;
+  int m_SaveListIoDepth     = 0;
+  bool m_SaveGameCache      = false;
+  bool m_SaveStats          = false;
+
+  // whether makeSaveGame(filepath, header) is implemented, checked the first time
+  // the save game cache would be used
+  mutable std::once_flag m_HeaderSavesChecked;
+  mutable bool m_HeaderSaves = false;
+
+  // guards the index and the last report, since listSaves() can be called from
+  // several threads at once
+  mutable std::mutex m_SaveIndexMutex;
+
+  mutable GamebryoSaveStats::Report m_LastSaveScan;
+
+  // index of the last directory listed, so that listing it again only parses
+  // the saves that changed, living on the thread of the game
+  mutable std::shared_ptr<GamebryoSaveGameIndex> m_SaveIndex;
+
+  // pool for GamebryoSaveGame::prefetchDataFields(), kept small since loading is
+  // mostly I/O, and drained when the game is destroyed
+  mutable QThreadPool m_PrefetchPool;
+
+  // pool for forEachConcurrently(), shared by listSaves() and the save game info
+  mutable QThreadPool m_WorkerPool;
 };
 
 #endif  // GAMEGAMEBRYO_H
@@ -0,0 +1,87 @@
+#include "gamebryobatchreader.h"
+
+#include <QFile>
+
+#include <algorithm>
+
+GamebryoBatchReader::GamebryoBatchReader(QStringList const& filepaths,
+                                         std::size_t size, int depth)
+    : m_Filepaths(filepaths), m_Size(size), m_Depth(std::max(depth, 1))
+{
+  // one thread per read in flight, the reads are blocking
+  const qsizetype threads = std::min<qsizetype>(m_Depth, m_Filepaths.size());
+  m_Workers.reserve(threads);
+  for (qsizetype i = 0; i < threads; ++i) {
+    m_Workers.emplace_back([this] {
+      work();
+    });
+  }
+}
+
+GamebryoBatchReader::~GamebryoBatchReader()
+{
+  {
+    std::lock_guard lock(m_Mutex);
+    m_Cancelled = true;
+  }
+  m_Changed.notify_all();
+  for (auto& worker : m_Workers) {
+    worker.join();
+  }
+}
+
+bool GamebryoBatchReader::next(Completion& completion)
+{
+  std::unique_lock lock(m_Mutex);
+  m_Changed.wait(lock, [this] {
+    return !m_Completed.empty() || m_Returned == m_Filepaths.size();
+  });
+  if (m_Completed.empty()) {
+    return false;
+  }
+
+  completion = std::move(m_Completed.front());
+  m_Completed.pop_front();
+  --m_InFlight;
+  ++m_Returned;
+  lock.unlock();
+
+  // room for another read, or all the files are done
+  m_Changed.notify_all();
+  return true;
+}
+
+void GamebryoBatchReader::work()
+{
+  for (;;) {
+    qsizetype index;
+    {
+      std::unique_lock lock(m_Mutex);
+      m_Changed.wait(lock, [this] {
+        return m_Cancelled || m_Next == m_Filepaths.size() || m_InFlight < m_Depth;
+      });
+      if (m_Cancelled || m_Next == m_Filepaths.size()) {
+        return;
+      }
+      index = m_Next++;
+      ++m_InFlight;
+    }
+
+    Completion completion;
+    completion.Index = index;
+
+    QFile file(m_Filepaths[index]);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+      completion.Data.resize(static_cast<qsizetype>(m_Size));
+      const qint64 read = file.read(completion.Data.data(), m_Size);
+      completion.Data.resize(std::max<qint64>(read, 0));
+      completion.Ok = read >= 0;
+    }
+
+    {
+      std::lock_guard lock(m_Mutex);
+      m_Completed.push_back(std::move(completion));
+    }
+    m_Changed.notify_all();
+  }
+}
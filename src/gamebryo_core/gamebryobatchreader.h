@@ -0,0 +1,82 @@
+#ifndef GAMEBRYOBATCHREADER_H
+#define GAMEBRYOBATCHREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Reads the start of many files concurrently, handing them out in the
+ *     order the reads complete.
+ *
+ * Opening and reading a file is mostly waiting on the disk or the network, so
+ * the reads of a whole directory are queued at once and kept `depth` deep on a
+ * set of threads, while the caller parses the files as they come in. At most
+ * `depth` files are read and not yet handed out at any time, which bounds the
+ * memory used when the parsing is slower than the reads.
+ */
+class GamebryoBatchReader
+{
+public:
+  struct Completion
+  {
+    // index of the file in the list given to the constructor
+    qsizetype Index = -1;
+
+    // the first bytes of the file, fewer if the file is shorter
+    QByteArray Data;
+
+    // false if the file could not be opened or read
+    bool Ok = false;
+  };
+
+  /**
+   * @param filepaths The files to read, all the reads are queued right away.
+   * @param size Number of bytes to read from the start of each file.
+   * @param depth Maximum number of reads in flight.
+   */
+  GamebryoBatchReader(QStringList const& filepaths, std::size_t size, int depth);
+
+  // pending reads are abandoned
+  ~GamebryoBatchReader();
+
+  GamebryoBatchReader(GamebryoBatchReader const&)            = delete;
+  GamebryoBatchReader& operator=(GamebryoBatchReader const&) = delete;
+
+  /**
+   * @brief Wait for the next completed read, this can be called from several
+   *     threads.
+   *
+   * @return false once all the files have been handed out.
+   */
+  bool next(Completion& completion);
+
+private:
+  void work();
+
+  QStringList m_Filepaths;
+  std::size_t m_Size;
+  qsizetype m_Depth;
+
+  std::mutex m_Mutex;
+  std::condition_variable m_Changed;
+  std::deque<Completion> m_Completed;
+
+  // next file to read, number of files read or being read and not yet handed
+  // out, and number of files handed out
+  qsizetype m_Next     = 0;
+  qsizetype m_InFlight = 0;
+  qsizetype m_Returned = 0;
+  bool m_Cancelled     = false;
+
+  std::vector<std::thread> m_Workers;
+};
+
+#endif  // GAMEBRYOBATCHREADER_H
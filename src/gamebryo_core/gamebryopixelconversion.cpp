@@ -0,0 +1,174 @@
+#include "gamebryopixelconversion.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GAMEBRYO_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC lets any function use any intrinsic, GCC and Clang need to be told
+#if defined(__GNUC__) || defined(__clang__)
+#define GAMEBRYO_TARGET(x) __attribute__((target(x)))
+#else
+#define GAMEBRYO_TARGET(x)
+#endif
+
+namespace
+{
+
+void convertRGBScalar(const uint8_t* src, uint32_t* dst, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; ++i, src += 3) {
+    dst[i] = 0xff000000u | (uint32_t(src[0]) << 16) | (uint32_t(src[1]) << 8) |
+             uint32_t(src[2]);
+  }
+}
+
+void convertRGBAScalar(const uint8_t* src, uint32_t* dst, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; ++i, src += 4) {
+    dst[i] = (uint32_t(src[3]) << 24) | (uint32_t(src[0]) << 16) |
+             (uint32_t(src[1]) << 8) | uint32_t(src[2]);
+  }
+}
+
+void accumulateScalar(const uint8_t* src, uint32_t* sums, std::size_t count)
+{
+  for (std::size_t i = 0; i < count; ++i) {
+    sums[i] += src[i];
+  }
+}
+
+#ifdef GAMEBRYO_X86
+
+GAMEBRYO_TARGET("sse2")
+void accumulateSSE2(const uint8_t* src, uint32_t* sums, std::size_t count)
+{
+  // 16 bytes per iteration, widened to 16-bit and then to 32-bit by interleaving
+  // them with zeros
+  const __m128i zero = _mm_setzero_si128();
+
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i lo = _mm_unpacklo_epi8(in, zero);
+    const __m128i hi = _mm_unpackhi_epi8(in, zero);
+    const __m128i words[4] = {
+        _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+        _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)};
+
+    auto* out = reinterpret_cast<__m128i*>(sums + i);
+    for (int j = 0; j < 4; ++j) {
+      _mm_storeu_si128(out + j, _mm_add_epi32(_mm_loadu_si128(out + j), words[j]));
+    }
+  }
+  accumulateScalar(src + i, sums + i, count - i);
+}
+
+// Both conversions boil down to a byte shuffle within each group of pixels,
+// which needs SSSE3 (pshufb); there is no sensible SSE2-only version.
+
+GAMEBRYO_TARGET("ssse3")
+void convertRGBSSSE3(const uint8_t* src, uint32_t* dst, std::size_t count)
+{
+  // 4 pixels (12 bytes) per iteration, the 16-byte load reads 4 bytes ahead so
+  // stop while there are still at least 6 pixels left
+  const __m128i shuffle =
+      _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+
+  std::size_t i = 0;
+  for (; i + 6 <= count; i += 4) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+    __m128i out = _mm_or_si128(_mm_shuffle_epi8(in, shuffle), alpha);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out);
+  }
+  convertRGBScalar(src + i * 3, dst + i, count - i);
+}
+
+GAMEBRYO_TARGET("ssse3")
+void convertRGBASSSE3(const uint8_t* src, uint32_t* dst, std::size_t count)
+{
+  const __m128i shuffle =
+      _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_shuffle_epi8(in, shuffle));
+  }
+  convertRGBAScalar(src + i * 4, dst + i, count - i);
+}
+
+// AVX2 versions were measured as well, and were no faster since the kernels are
+// limited by memory bandwidth
+enum class SimdLevel
+{
+  NONE,
+  SSE2,
+  SSSE3
+};
+
+SimdLevel detectSimdLevel()
+{
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  const bool sse2  = (info[3] & (1 << 26)) != 0;
+  const bool ssse3 = (info[2] & (1 << 9)) != 0;
+
+  return ssse3 ? SimdLevel::SSSE3 : sse2 ? SimdLevel::SSE2 : SimdLevel::NONE;
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3")) {
+    return SimdLevel::SSSE3;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return SimdLevel::SSE2;
+  }
+  return SimdLevel::NONE;
+#endif
+}
+
+SimdLevel simdLevel()
+{
+  static const SimdLevel level = detectSimdLevel();
+  return level;
+}
+
+#endif  // GAMEBRYO_X86
+
+}  // namespace
+
+void convertRGB888ToRGB32(const uint8_t* src, uint32_t* dst, std::size_t count)
+{
+#ifdef GAMEBRYO_X86
+  if (simdLevel() == SimdLevel::SSSE3) {
+    return convertRGBSSSE3(src, dst, count);
+  }
+#endif
+  convertRGBScalar(src, dst, count);
+}
+
+void convertRGBA8888ToARGB32(const uint8_t* src, uint32_t* dst, std::size_t count)
+{
+#ifdef GAMEBRYO_X86
+  if (simdLevel() == SimdLevel::SSSE3) {
+    return convertRGBASSSE3(src, dst, count);
+  }
+#endif
+  convertRGBAScalar(src, dst, count);
+}
+
+void accumulateBytes(const uint8_t* src, uint32_t* sums, std::size_t count)
+{
+#ifdef GAMEBRYO_X86
+  if (simdLevel() >= SimdLevel::SSE2) {
+    return accumulateSSE2(src, sums, count);
+  }
+#endif
+  accumulateScalar(src, sums, count);
+}
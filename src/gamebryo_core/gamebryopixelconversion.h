@@ -0,0 +1,25 @@
+#ifndef GAMEBRYOPIXELCONVERSION_H
+#define GAMEBRYOPIXELCONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Conversion of the raw pixels stored in saves to the 32-bit formats Qt draws
+// without further conversion (QImage::Format_RGB32 and Format_ARGB32_Premultiplied),
+// and the sums thumbnails are averaged from.
+//
+// The implementation is picked at runtime depending on the CPU (SSSE3, SSE2 or
+// plain C++).
+
+// Convert `count` packed RGB888 pixels to 0xffRRGGBB.
+void convertRGB888ToRGB32(const uint8_t* src, uint32_t* dst, std::size_t count);
+
+// Convert `count` RGBA8888 pixels to 0xAARRGGBB, premultiplied pixels stay
+// premultiplied.
+void convertRGBA8888ToARGB32(const uint8_t* src, uint32_t* dst, std::size_t count);
+
+// Add `count` bytes to the `count` sums, e.g. the channels of a row of pixels to those
+// of the rows above.
+void accumulateBytes(const uint8_t* src, uint32_t* sums, std::size_t count);
+
+#endif  // GAMEBRYOPIXELCONVERSION_H
@@ -0,0 +1,121 @@
+#include "gamebryopluginnames.h"
+
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+namespace
+{
+// a save has at most three plugin lists
+constexpr std::size_t MAX_REMEMBERED = 3;
+
+struct Remembered
+{
+  // a copy, so that the list detaches from it if it is modified
+  QStringList Names;
+  std::vector<GamebryoPluginNames::Id> Ids;
+};
+
+std::deque<Remembered>& remembered()
+{
+  thread_local std::deque<Remembered> lists;
+  return lists;
+}
+}  // namespace
+
+GamebryoPluginNames& GamebryoPluginNames::instance()
+{
+  static GamebryoPluginNames names;
+  return names;
+}
+
+GamebryoPluginNames::Id GamebryoPluginNames::insert(QString const& name,
+                                                    QString* pooled)
+{
+  // names are nearly always in the pool already, so look them up without
+  // blocking the other threads first
+  {
+    std::shared_lock lock(m_Mutex);
+    auto it = m_Ids.constFind(name);
+    if (it != m_Ids.constEnd()) {
+      if (pooled != nullptr) {
+        *pooled = m_Names.at(*it);
+      }
+      return *it;
+    }
+  }
+
+  std::unique_lock lock(m_Mutex);
+  auto it = m_Ids.constFind(name);
+  Id id;
+  if (it != m_Ids.constEnd()) {
+    id = *it;
+  } else {
+    id = static_cast<Id>(m_Names.size());
+    m_Names.push_back(name);
+    m_Ids.insert(name, id);
+  }
+  if (pooled != nullptr) {
+    *pooled = m_Names.at(id);
+  }
+  return id;
+}
+
+GamebryoPluginNames::Id GamebryoPluginNames::intern(QString const& name)
+{
+  return insert(name, nullptr);
+}
+
+QString GamebryoPluginNames::pooled(QString const& name, Id* id)
+{
+  QString result;
+  const Id pooledId = insert(name, &result);
+  if (id != nullptr) {
+    *id = pooledId;
+  }
+  return result;
+}
+
+std::vector<GamebryoPluginNames::Id> GamebryoPluginNames::intern(QStringList& names)
+{
+  auto& lists = remembered();
+  for (auto it = lists.begin(); it != lists.end(); ++it) {
+    if (it->Names.constData() == names.constData() &&
+        it->Names.size() == names.size()) {
+      std::vector<Id> ids = std::move(it->Ids);
+      lists.erase(it);
+      return ids;
+    }
+  }
+
+  std::vector<Id> ids;
+  ids.reserve(names.size());
+  for (QString& name : names) {
+    ids.push_back(insert(name, &name));
+  }
+  return ids;
+}
+
+void GamebryoPluginNames::remember(QStringList const& names, std::vector<Id> ids)
+{
+  auto& lists = remembered();
+  if (lists.size() == MAX_REMEMBERED) {
+    lists.pop_front();
+  }
+  lists.push_back({names, std::move(ids)});
+}
+
+QString GamebryoPluginNames::name(Id id) const
+{
+  std::shared_lock lock(m_Mutex);
+  if (id >= static_cast<std::size_t>(m_Names.size())) {
+    throw std::out_of_range("unknown plugin name id");
+  }
+  return m_Names[id];
+}
+
+std::size_t GamebryoPluginNames::size() const
+{
+  std::shared_lock lock(m_Mutex);
+  return m_Names.size();
+}
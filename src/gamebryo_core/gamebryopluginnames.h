@@ -0,0 +1,81 @@
+#ifndef GAMEBRYOPLUGINNAMES_H
+#define GAMEBRYOPLUGINNAMES_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include <cstdint>
+#include <shared_mutex>
+#include <vector>
+
+/**
+ * @brief Process-wide pool of the plugin names found in saves.
+ *
+ * Saves of a playthrough list nearly the same plugins, so each distinct name is
+ * stored once and every save shares it, either as a copy of the pooled QString
+ * (which shares its storage) or as a small id. Two names are equal if and only
+ * if their ids are, names are compared case-sensitively. Ids are never reused.
+ *
+ * All the functions are thread-safe.
+ */
+class GamebryoPluginNames
+{
+public:
+  using Id = uint32_t;
+
+  static GamebryoPluginNames& instance();
+
+  /**
+   * @return the id of the given name, which is added to the pool if needed.
+   */
+  Id intern(QString const& name);
+
+  /**
+   * @return the pooled copy of the given name, which is added to the pool if
+   *     needed, and sets `id` to its id if it is not null.
+   */
+  QString pooled(QString const& name, Id* id = nullptr);
+
+  /**
+   * @brief Replace the names in the list by their pooled copies.
+   *
+   * If the list is the one last passed to remember() on this thread, and was not
+   * modified since, its names are already pooled and the remembered ids are
+   * returned without looking the names up again.
+   *
+   * @return the ids of the names, in the same order.
+   */
+  std::vector<Id> intern(QStringList& names);
+
+  /**
+   * @brief Keep the ids of a list of pooled names built on this thread, e.g. by
+   *     GamebryoSaveFile, for the next call to intern() with the same list.
+   *
+   * Only the last few lists are kept.
+   */
+  void remember(QStringList const& names, std::vector<Id> ids);
+
+  /**
+   * @return the pooled name with the given id.
+   */
+  QString name(Id id) const;
+
+  /**
+   * @return the number of names in the pool, ids are below this.
+   */
+  std::size_t size() const;
+
+private:
+  GamebryoPluginNames() = default;
+
+  // id of the name, adding it if needed, and sets `pooled` to the pooled copy if
+  // it is not null
+  Id insert(QString const& name, QString* pooled);
+
+  mutable std::shared_mutex m_Mutex;
+  QHash<QString, Id> m_Ids;
+  QStringList m_Names;
+};
+
+#endif  // GAMEBRYOPLUGINNAMES_H
@@ -0,0 +1,1150 @@
+#include "gamebryosavefile.h"
+
+#include <QFile>
+#include <QVarLengthArray>
+#include <QtGlobal>
+
+#include <lz4.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "gamebryopixelconversion.h"
+#include "gamebryopluginnames.h"
+#include "gamebryosavestats.h"
+
+#define CHUNK 16384
+
+// size of the decompression window, data is only uncompressed this much at
+// a time unless a single read asks for more
+#define WINDOW 65536
+
+// when the file cannot be mapped, it is read this much at a time, in blocks
+// aligned to READ_ALIGN in the file, so that the header fields, the markers
+// after them and the strings all come from one or two reads
+#define READAHEAD 65536
+#define READ_ALIGN 4096
+
+struct GamebryoSaveFile::Inflater
+{
+  z_stream stream{};
+  bool initialized = false;
+
+  // input buffer, only used when the file could not be mapped
+  std::unique_ptr<char[]> input;
+
+  ~Inflater()
+  {
+    if (initialized) {
+      inflateEnd(&stream);
+    }
+  }
+};
+
+struct GamebryoSaveFile::Scratch
+{
+  // decompression window
+  QByteArray buffer;
+  Inflater inflater;
+
+  // bytes read from the file and compressed LZ4 block, only used when the file
+  // could not be mapped
+  QByteArray file;
+  QByteArray compressed;
+
+  // values that straddle the end of a window
+  QByteArray spill;
+};
+
+// above this, scratch buffers are released rather than kept for the next save
+#define MAX_SCRATCH (1024 * 1024)
+
+// largest screenshot side accepted, so that sizes computed from garbage
+// dimensions cannot overflow
+#define MAX_IMAGE_SIDE 32768
+
+// plugin lists are never anywhere near this long, so a larger count in a
+// corrupted save does not get to reserve memory up front
+#define MAX_PLUGINS_RESERVE 65536
+
+using Stats = GamebryoSaveStats;
+
+namespace
+{
+// resize a scratch buffer, counting the allocation if it has to grow
+void resizeBuffer(QByteArray& buffer, qsizetype size)
+{
+  if (size > buffer.capacity()) {
+    Stats::count(Stats::Allocations);
+  }
+  buffer.resize(size);
+}
+}  // namespace
+
+const char* GamebryoSaveFile::Source::bytes(std::size_t length)
+{
+  if (length > 0 && m_Pos == m_End) {
+    refill(length);
+  }
+  if (static_cast<std::size_t>(m_End - m_Pos) >= length) {
+    const char* data = m_Pos;
+    m_Pos += length;
+    return data;
+  }
+
+  resizeBuffer(m_Spill, length);
+  readMore(m_Spill.data(), length);
+  return m_Spill.constData();
+}
+
+void GamebryoSaveFile::Source::readMore(void* buff, std::size_t length)
+{
+  char* out = static_cast<char*>(buff);
+  while (length > 0) {
+    if (m_Pos == m_End) {
+      refill(length);
+    }
+    const std::size_t count = std::min(length, static_cast<std::size_t>(m_End - m_Pos));
+    std::memcpy(out, m_Pos, count);
+    m_Pos += count;
+    out += count;
+    length -= count;
+  }
+}
+
+void GamebryoSaveFile::Source::skipMore(std::size_t length)
+{
+  while (length > 0) {
+    if (m_Pos == m_End) {
+      refill(length);
+    }
+    const std::size_t count = std::min(length, static_cast<std::size_t>(m_End - m_Pos));
+    m_Pos += count;
+    length -= count;
+  }
+}
+
+// The file itself. When the file is mapped, the window is the whole file and
+// values are decoded straight out of it, otherwise the window is a block read
+// ahead of the position.
+class GamebryoSaveFile::FileSource : public Source
+{
+public:
+  // the prefix of the file, already read, which is then used as if it was the
+  // whole file mapped
+  FileSource(QByteArray const& prefix, Scratch& scratch, QFile& file)
+      : Source(scratch.spill), m_File(file), m_Buffer(scratch.file),
+        m_Prefix(prefix.size())
+  {
+    m_Map  = reinterpret_cast<const uchar*>(prefix.constData());
+    m_Size = prefix.size();
+    m_Pos = m_Mark = prefix.constData();
+    m_End          = m_Pos + m_Size;
+  }
+
+  FileSource(QFile& file, Scratch& scratch, std::size_t prefix)
+      : Source(scratch.spill), m_File(file), m_Buffer(scratch.file), m_Prefix(prefix)
+  {
+    // Map the whole file so that reads are served from memory instead of going
+    // through one syscall each. If mapping fails (empty file, unusual device...)
+    // we simply fall back to reading through QFile. A prefix is read instead, in
+    // a single read.
+    const qint64 size = m_File.size();
+    Stats::count(Stats::Syscalls);
+    if (size > 0 && m_Prefix == 0 && !threadUnmapped()) {
+      m_Map = m_File.map(0, size);
+      Stats::count(Stats::Syscalls);
+    }
+    if (m_Map != nullptr) {
+      m_Size = size;
+      m_Pos  = reinterpret_cast<const char*>(m_Map);
+      m_End  = m_Pos + size;
+      m_Mark = m_Pos;
+    }
+  }
+
+  ~FileSource() { countMapped(); }
+
+  // the mapped file, or its prefetched prefix, or nullptr
+  const uchar* map() const { return m_Map; }
+
+  qint64 size() const { return m_Map != nullptr ? m_Size : m_File.size(); }
+
+  qint64 pos() const
+  {
+    if (m_Map != nullptr) {
+      return m_Pos - reinterpret_cast<const char*>(m_Map);
+    }
+    return m_File.pos() - (m_End - m_Pos);
+  }
+
+  void seek(qint64 pos)
+  {
+    if (m_Map != nullptr) {
+      countMapped();
+      // like QFile, seeking past the end is allowed, reading from there is not
+      m_Pos = reinterpret_cast<const char*>(m_Map) + std::clamp<qint64>(pos, 0, m_Size);
+      m_Mark = m_Pos;
+    } else if (m_End != nullptr && pos >= bufferPos() && pos < m_File.pos()) {
+      // still in the block read ahead, e.g. when rewinding over a field
+      m_Pos = m_Buffer.constData() + (pos - bufferPos());
+    } else {
+      m_Pos = m_End = nullptr;
+      Stats::count(Stats::Syscalls);
+      if (!m_File.seek(pos)) {
+        throw std::runtime_error("unexpected end of file");
+      }
+    }
+  }
+
+  // read at most `length` bytes, returns the number of bytes read
+  qint64 readSome(char* out, qint64 length)
+  {
+    const qint64 buffered = std::min<qint64>(length, m_End - m_Pos);
+    if (buffered > 0) {
+      std::memcpy(out, m_Pos, buffered);
+      m_Pos += buffered;
+    }
+    if (buffered == length || m_Map != nullptr) {
+      return buffered;
+    }
+
+    // small reads go through the buffer, larger ones straight to the output
+    // unless they are limited to the prefix
+    if (length - buffered < READAHEAD || m_Prefix > 0) {
+      if (!fill(length - buffered)) {
+        return buffered;
+      }
+      const qint64 more = std::min<qint64>(length - buffered, m_End - m_Pos);
+      std::memcpy(out + buffered, m_Pos, more);
+      m_Pos += more;
+      return buffered + more;
+    }
+
+    // the buffer no longer ends where the file is, drop it so that seek() does not
+    // rewind into it
+    m_Pos = m_End = nullptr;
+    const qint64 read =
+        std::max<qint64>(m_File.read(out + buffered, length - buffered), 0);
+    Stats::count(Stats::Syscalls);
+    Stats::count(Stats::BytesRead, read);
+    return buffered + read;
+  }
+
+  void close()
+  {
+    // closing the file also unmaps it
+    countMapped();
+    Stats::count(Stats::Syscalls);
+    m_Map  = nullptr;
+    m_Size = 0;
+    m_Pos = m_End = nullptr;
+    m_File.close();
+  }
+
+protected:
+  void refill(std::size_t wanted) override
+  {
+    if (m_Prefix > 0 && pos() >= static_cast<qint64>(m_Prefix)) {
+      throw std::runtime_error("read past the prefix of the file");
+    }
+    if (m_Map != nullptr || !fill(wanted)) {
+      throw std::runtime_error("unexpected end of file");
+    }
+  }
+
+  void skipMore(std::size_t length) override
+  {
+    // read through short skips, the next block is read anyway
+    const std::size_t buffered = m_End - m_Pos;
+    if (m_Map != nullptr || length - buffered < READAHEAD) {
+      Source::skipMore(length);
+      return;
+    }
+
+    // seek over what is not buffered rather than reading it
+    length -= buffered;
+    m_Pos = m_End = nullptr;
+    Stats::count(Stats::Syscalls);
+    if (!m_File.seek(m_File.pos() + length)) {
+      throw std::runtime_error("unexpected end of file");
+    }
+  }
+
+private:
+  // offset in the file of the start of the buffer
+  qint64 bufferPos() const { return m_File.pos() - (m_End - m_Buffer.constData()); }
+
+  // read the next block into the buffer, at least `wanted` bytes up to the next
+  // aligned offset, returns false at the end of the file
+  bool fill(std::size_t wanted)
+  {
+    const qint64 from = m_File.pos();
+    const qint64 end  = from + std::max<qint64>(wanted, READAHEAD);
+    qint64 to         = (end + READ_ALIGN - 1) / READ_ALIGN * READ_ALIGN;
+    if (m_Prefix > 0) {
+      to = std::min<qint64>(to, m_Prefix);
+    }
+    if (to <= from) {
+      return false;
+    }
+
+    resizeBuffer(m_Buffer, to - from);
+    const qint64 read = m_File.read(m_Buffer.data(), to - from);
+    Stats::count(Stats::Syscalls);
+    if (read <= 0) {
+      m_Pos = m_End = nullptr;
+      return false;
+    }
+    Stats::count(Stats::BytesRead, read);
+    m_Pos = m_Buffer.constData();
+    m_End = m_Pos + read;
+    return true;
+  }
+
+  // a mapped file is read through without any call, so count the bytes that
+  // were gone through since the last seek
+  void countMapped()
+  {
+    if (m_Map != nullptr && m_Pos > m_Mark) {
+      Stats::count(Stats::BytesRead, m_Pos - m_Mark);
+    }
+    m_Mark = m_Pos;
+  }
+
+  QFile& m_File;
+  QByteArray& m_Buffer;
+  const uchar* m_Map = nullptr;
+  qint64 m_Size      = 0;
+
+  // size of the prefix the reads are limited to, 0 for the whole file
+  std::size_t m_Prefix;
+
+  // position of the last seek in the mapped file
+  const char* m_Mark = nullptr;
+};
+
+// Compression type 1, a sequence of zlib streams ("chunks") aligned to 16 bytes
+// in the file. The window is the scratch buffer, which is inflated into from
+// the start each time it has been fully read.
+class GamebryoSaveFile::ZlibSource : public Source
+{
+public:
+  ZlibSource(FileSource& file, Scratch& scratch, uint64_t firstChunk,
+             uint64_t uncompressedSize)
+      : Source(scratch.spill), m_File(file), m_Buffer(scratch.buffer),
+        m_Inflater(scratch.inflater), m_NextChunk(firstChunk)
+  {
+    // the buffer only needs to be large enough to amortize the calls to inflate
+    resizeBuffer(m_Buffer, std::clamp<uint64_t>(uncompressedSize, CHUNK, WINDOW));
+  }
+
+  // move to the next chunk, whatever is left of the current one is discarded
+  bool nextChunk()
+  {
+    // the end of the current chunk, and thus the start of the next one, is only
+    // known once it has been fully inflated
+    while (m_Active) {
+      m_Filled = 0;
+      if (!inflateChunk(m_Buffer.size())) {
+        return false;
+      }
+    }
+    m_Pos = m_End = nullptr;
+
+    if (m_NextChunk >= static_cast<uint64_t>(m_File.size())) {
+      return false;
+    }
+
+    z_stream& stream = m_Inflater.stream;
+
+    // the first chunk initializes the stream, the following ones simply reset it
+    if (!m_Inflater.initialized) {
+      if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        return false;
+      }
+      m_Inflater.initialized = true;
+    } else if (inflateReset(&stream) != Z_OK) {
+      return false;
+    }
+    stream.avail_in = 0;
+
+    if (m_File.map() == nullptr) {
+      m_File.seek(m_NextChunk);
+      if (!m_Inflater.input) {
+        m_Inflater.input = std::make_unique<char[]>(CHUNK);
+        Stats::count(Stats::Allocations);
+      }
+    }
+
+    // nothing is inflated until the data is actually read
+    m_Chunk  = m_NextChunk;
+    m_Fed    = 0;
+    m_Active = true;
+
+    return true;
+  }
+
+protected:
+  void refill(std::size_t wanted) override
+  {
+    // everything has been read, start over at the beginning of the buffer
+    m_Filled = 0;
+
+    const qsizetype target =
+        std::min<qsizetype>(m_Buffer.size(), std::max<std::size_t>(wanted, CHUNK));
+    while (m_Filled == 0) {
+      if (!m_Active && !nextChunk()) {
+        throw std::runtime_error("unexpected end of file");
+      }
+      if (!inflateChunk(target)) {
+        throw std::runtime_error("unexpected end of file");
+      }
+    }
+
+    m_Pos = m_Buffer.constData();
+    m_End = m_Pos + m_Filled;
+  }
+
+private:
+  // inflate the current chunk until the buffer is filled up to target or the
+  // chunk ends
+  bool inflateChunk(qsizetype target)
+  {
+    Stats::Timer timer(Stats::Decompress);
+    z_stream& stream = m_Inflater.stream;
+
+    // chunks are 16-bytes aligned
+    auto finishChunk = [&] {
+      const uint64_t end = m_Chunk + stream.total_in;
+      m_NextChunk        = (end + 15) / 16 * 16;
+      m_Active           = false;
+    };
+
+    while (m_Filled < target) {
+      if (stream.avail_in == 0) {
+        if (m_File.map() != nullptr) {
+          // feed zlib directly from the mapped file
+          const uint64_t offset = m_Chunk + m_Fed;
+          const uint64_t size   = m_File.size();
+          const uint64_t left   = offset < size ? size - offset : 0;
+          stream.avail_in = static_cast<uInt>(std::min<uint64_t>(CHUNK, left));
+          stream.next_in  = const_cast<Bytef*>(m_File.map() + offset);
+          Stats::count(Stats::BytesRead, stream.avail_in);
+        } else {
+          stream.avail_in =
+              static_cast<uInt>(m_File.readSome(m_Inflater.input.get(), CHUNK));
+          stream.next_in = reinterpret_cast<Bytef*>(m_Inflater.input.get());
+        }
+        m_Fed += stream.avail_in;
+
+        // the file, or the prefix read, ends before the zlib stream does
+        if (stream.avail_in == 0) {
+          m_Active = false;
+          throw std::runtime_error("unexpected end of file");
+        }
+      }
+
+      // inflate straight into the free space at the end of the buffer
+      stream.next_out  = reinterpret_cast<Bytef*>(m_Buffer.data() + m_Filled);
+      stream.avail_out = static_cast<uInt>(target - m_Filled);
+      const uInt before = stream.avail_out;
+      const int zlibRet = inflate(&stream, Z_NO_FLUSH);
+      m_Filled += before - stream.avail_out;
+      Stats::count(Stats::BytesInflated, before - stream.avail_out);
+
+      if (zlibRet == Z_STREAM_END) {
+        finishChunk();
+        return true;
+      }
+      if ((zlibRet != Z_OK) && (zlibRet != Z_BUF_ERROR)) {
+        m_Active = false;
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  FileSource& m_File;
+  QByteArray& m_Buffer;
+  Inflater& m_Inflater;
+  uint64_t m_NextChunk;
+
+  // chunk being inflated, its offset in the file and the number of compressed
+  // bytes handed to zlib so far
+  bool m_Active  = false;
+  uint64_t m_Chunk = 0;
+  uint64_t m_Fed   = 0;
+
+  // bytes of the buffer inflated since it was last refilled
+  qsizetype m_Filled = 0;
+};
+
+// Compression type 2, a single LZ4 block. Blocks cannot be decoded a piece at a
+// time, so the block is decoded again from the start up to a larger target,
+// doubling it each time to keep the total work linear.
+class GamebryoSaveFile::Lz4Source : public Source
+{
+public:
+  Lz4Source(Scratch& scratch, const char* data, uint32_t size,
+            uint32_t uncompressedSize)
+      : Source(scratch.spill), m_Buffer(scratch.buffer), m_Data(data), m_Size(size),
+        m_UncompressedSize(uncompressedSize)
+  {}
+
+protected:
+  void refill(std::size_t wanted) override
+  {
+    Stats::Timer timer(Stats::Decompress);
+
+    // the window is empty, so everything decoded so far has been read
+    const uint64_t decoded = m_End != nullptr ? m_End - m_Buffer.constData() : 0;
+    const uint64_t target  = std::min<uint64_t>(
+        {m_UncompressedSize, static_cast<uint64_t>(std::numeric_limits<int>::max()),
+         std::max<uint64_t>({2 * decoded, decoded + wanted, WINDOW})});
+    if (target <= decoded) {
+      throw std::runtime_error("unexpected end of file");
+    }
+
+    resizeBuffer(m_Buffer, target);
+    const int result =
+        LZ4_decompress_safe_partial(m_Data, m_Buffer.data(), m_Size,
+                                    static_cast<int>(target), static_cast<int>(target));
+
+    // a negative value means the block is corrupted
+    if (result <= 0 || static_cast<uint64_t>(result) <= decoded) {
+      throw std::runtime_error("unexpected end of file");
+    }
+    Stats::count(Stats::BytesInflated, result - decoded);
+    m_Pos = m_Buffer.constData() + decoded;
+    m_End = m_Buffer.constData() + result;
+  }
+
+private:
+  QByteArray& m_Buffer;
+  const char* m_Data;
+  uint32_t m_Size;
+  uint32_t m_UncompressedSize;
+};
+
+// Body of saves with an unknown compression, which reads as zeros so that the
+// fields read from it are empty, as they always have been.
+class GamebryoSaveFile::NullSource : public Source
+{
+public:
+  using Source::Source;
+
+protected:
+  void refill(std::size_t) override
+  {
+    static const char zeros[CHUNK] = {};
+    m_Pos = zeros;
+    m_End = zeros + CHUNK;
+  }
+};
+
+GamebryoSaveFile::GamebryoSaveFile(QString const& filepath, QString const& expected,
+                                   std::size_t prefix)
+    : m_File(filepath), m_PluginString(StringType::TYPE_WSTRING),
+      m_PluginStringFormat(StringFormat::UTF8)
+{
+  Stats::Timer openTimer(Stats::Open);
+
+  const Prefetched* prefetched = threadPrefetched();
+  if (prefix == 0 || prefetched == nullptr || prefetched->m_Filepath != filepath ||
+      static_cast<std::size_t>(prefetched->m_Data.size()) > prefix) {
+    prefetched = nullptr;
+
+    Stats::count(Stats::Syscalls);
+    // reads are buffered by FileSource, in larger blocks than QIODevice does
+    if (!m_File.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+      throw std::runtime_error(
+          QObject::tr("failed to open %1").arg(filepath).toUtf8().constData());
+    }
+  }
+
+  m_Scratch = std::move(threadScratch());
+  if (!m_Scratch) {
+    m_Scratch = std::make_unique<Scratch>();
+    Stats::count(Stats::Allocations);
+  }
+
+  if (prefetched != nullptr) {
+    m_FileSource = std::make_unique<FileSource>(prefetched->m_Data, *m_Scratch, m_File);
+  } else {
+    m_FileSource = std::make_unique<FileSource>(m_File, *m_Scratch, prefix);
+  }
+  m_Body = m_FileSource.get();
+  Stats::count(Stats::Allocations);
+
+  Stats::Timer magicTimer(Stats::Magic);
+  QVarLengthArray<char, 32> fileID(expected.length() + 1);
+  std::memset(fileID.data(), 0, fileID.size());
+  file().readSome(fileID.data(), expected.length());
+
+  QString id(fileID.data());
+  if (expected != id) {
+    throw std::runtime_error(
+        QObject::tr("wrong file format - expected %1 got \'%2\' for %3")
+            .arg(expected)
+            .arg(id)
+            .arg(filepath)
+            .toUtf8()
+            .constData());
+  }
+}
+
+GamebryoSaveFile::~GamebryoSaveFile()
+{
+  // the sources refer to the scratch arena
+  m_Body = nullptr;
+  m_BodySource.reset();
+  m_FileSource.reset();
+
+  // hand the scratch arena back for the next save parsed on this thread, unless
+  // another wrapper already did
+  auto& scratch = threadScratch();
+  if (m_Scratch && !scratch) {
+    for (QByteArray* buffer :
+         {&m_Scratch->buffer, &m_Scratch->file, &m_Scratch->compressed}) {
+      if (buffer->capacity() > MAX_SCRATCH) {
+        *buffer = QByteArray();
+      }
+    }
+    scratch = std::move(m_Scratch);
+  }
+}
+
+std::unique_ptr<GamebryoSaveFile::Scratch>& GamebryoSaveFile::threadScratch()
+{
+  thread_local std::unique_ptr<Scratch> scratch;
+  return scratch;
+}
+
+GamebryoSaveFile::Prefetched*& GamebryoSaveFile::threadPrefetched()
+{
+  thread_local Prefetched* prefetched = nullptr;
+  return prefetched;
+}
+
+GamebryoSaveFile::Prefetched::Prefetched(QString const& filepath,
+                                         QByteArray const& data)
+    : m_Filepath(filepath), m_Data(data), m_Previous(threadPrefetched())
+{
+  threadPrefetched() = this;
+}
+
+GamebryoSaveFile::Prefetched::~Prefetched()
+{
+  threadPrefetched() = m_Previous;
+}
+
+bool& GamebryoSaveFile::threadUnmapped()
+{
+  thread_local bool unmapped = false;
+  return unmapped;
+}
+
+GamebryoSaveFile::Unmapped::Unmapped() : m_Previous(threadUnmapped())
+{
+  threadUnmapped() = true;
+}
+
+GamebryoSaveFile::Unmapped::~Unmapped()
+{
+  threadUnmapped() = m_Previous;
+}
+
+GamebryoSaveFile::FileSource& GamebryoSaveFile::file()
+{
+  return static_cast<FileSource&>(*m_FileSource);
+}
+
+void GamebryoSaveFile::setHasFieldMarkers(bool state)
+{
+  m_FileSource->setFieldMarkers(state);
+}
+
+void GamebryoSaveFile::setPluginString(StringType type)
+{
+  m_PluginString = type;
+}
+
+void GamebryoSaveFile::setPluginStringFormat(StringFormat type)
+{
+  m_PluginStringFormat = type;
+}
+
+namespace
+{
+// true if none of the bytes has its high bit set, checked eight bytes at a time
+bool isAscii(const char* data, std::size_t length)
+{
+  std::size_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + i, 8);
+    if (word & 0x8080808080808080ull) {
+      return false;
+    }
+  }
+  for (; i < length; ++i) {
+    if (static_cast<unsigned char>(data[i]) & 0x80) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void decodeString(const char* data, std::size_t length,
+                  GamebryoSaveFile::StringFormat format, QString& value)
+{
+  // strings stop at the first null, like the C strings they used to be read as
+  if (const void* end = std::memchr(data, '\0', length)) {
+    length = static_cast<const char*>(end) - data;
+  }
+
+  if (isAscii(data, length)) {
+    // ASCII reads the same in UTF-8 and in any local 8-bit code page, so simply
+    // widen the bytes into the storage of the string, which is reused if unshared
+    value.resize(static_cast<qsizetype>(length));
+    QChar* out = value.data();
+    for (std::size_t i = 0; i < length; ++i) {
+      out[i] = QLatin1Char(data[i]);
+    }
+  } else if (format == GamebryoSaveFile::StringFormat::UTF8) {
+    value = QString::fromUtf8(data, static_cast<qsizetype>(length));
+  } else {
+    value = QString::fromLocal8Bit(data, static_cast<qsizetype>(length));
+  }
+}
+}  // namespace
+
+void GamebryoSaveFile::readString(Source& source, QString& value)
+{
+  // BZSTRING lengths count the terminating null, which is dropped when decoding
+  // like any other null
+  std::size_t length;
+  if (m_PluginString == StringType::TYPE_BSTRING ||
+      m_PluginString == StringType::TYPE_BZSTRING) {
+    uint8_t len;
+    source.read(len);
+    length = len;
+  } else {
+    uint16_t len;
+    source.read(len);
+    length = len;
+  }
+
+  if (source.hasFieldMarkers()) {
+    source.skip(1);
+  }
+
+  // decode before moving on, the bytes may be in the window of the source
+  decodeString(source.bytes(length), length, m_PluginStringFormat, value);
+
+  if (source.hasFieldMarkers()) {
+    source.skip(1);
+  }
+}
+
+template <>
+void GamebryoSaveFile::read<QString>(QString& value)
+{
+  readString(*m_Body, value);
+}
+
+void GamebryoSaveFile::seek(uint64_t pos)
+{
+  file().seek(pos);
+}
+
+void GamebryoSaveFile::rewind(std::size_t length)
+{
+  file().seek(file().pos() - static_cast<qint64>(length));
+}
+
+void GamebryoSaveFile::read(void* buff, std::size_t length)
+{
+  m_FileSource->read(buff, length);
+}
+
+QImage GamebryoSaveFile::readImage(int scale, bool alpha)
+{
+  uint32_t width;
+  read(width);
+  uint32_t height;
+  read(height);
+  return readImage(width, height, scale, alpha);
+}
+
+QImage GamebryoSaveFile::readImage(uint32_t width, uint32_t height, int scale,
+                                   bool alpha)
+{
+  Stats::Timer timer(Stats::Screenshot);
+
+  if (width > MAX_IMAGE_SIDE || height > MAX_IMAGE_SIDE) {
+    throw std::runtime_error("invalid screenshot size");
+  }
+
+  if (scale > 0 && static_cast<uint32_t>(scale) < width) {
+    return readThumbnail(width, height, scale, alpha);
+  }
+
+  // convert straight to the format Qt draws, rather than letting it convert the
+  // image later on
+  const int bpp               = alpha ? 4 : 3;
+  const std::size_t rowSize   = static_cast<std::size_t>(width) * bpp;
+  const QImage::Format format =
+      alpha ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+  const auto convert = alpha ? convertRGBA8888ToARGB32 : convertRGB888ToRGB32;
+
+  if (width == 0 || height == 0) {
+    return QImage();
+  }
+
+  // check before allocating the image, the size may be garbage
+  const qint64 remaining = file().size() - file().pos();
+  if (remaining < 0 || static_cast<std::size_t>(remaining) / rowSize < height) {
+    throw std::runtime_error("unexpected end of file");
+  }
+
+  QImage image(width, height, format);
+  if (image.isNull()) {
+    throw std::runtime_error("invalid screenshot size");
+  }
+  Stats::count(Stats::Allocations);
+  for (uint32_t y = 0; y < height; ++y) {
+    const auto* pixels = reinterpret_cast<const uchar*>(m_FileSource->bytes(rowSize));
+    convert(pixels, reinterpret_cast<uint32_t*>(image.scanLine(y)), width);
+  }
+
+  if (scale != 0) {
+    Stats::count(Stats::Allocations);
+    return image.scaledToWidth(scale);
+  } else {
+    return image;
+  }
+}
+
+namespace
+{
+// Downscales rows of 8-bit RGB or RGBA pixels with a box filter as they come
+// in, each target pixel being the average of the source pixels it covers. The
+// target must be a 32-bit RGB32 or ARGB32 image.
+//
+// The rows are summed as they are, channel by channel with accumulateBytes(), and
+// the source columns are only summed up once per target row.
+class BoxDownscaler
+{
+public:
+  BoxDownscaler(QImage& target, int sourceWidth, int sourceHeight, int bpp)
+      : m_Target(target), m_SourceHeight(sourceHeight), m_Bpp(bpp),
+        m_Columns(target.width() + 1), m_Sums(std::size_t(sourceWidth) * bpp)
+  {
+    // source columns [m_Columns[x], m_Columns[x + 1]) make up target column x
+    for (int x = 0; x <= target.width(); ++x) {
+      m_Columns[x] = static_cast<int>(qint64(x) * sourceWidth / target.width());
+    }
+  }
+
+  void addRow(const uchar* row)
+  {
+    accumulateBytes(row, m_Sums.data(), m_Sums.size());
+
+    ++m_SourceRow;
+    ++m_RowsInSum;
+
+    // last source row of the current target row
+    const int end = static_cast<int>(qint64(m_TargetRow + 1) * m_SourceHeight /
+                                     m_Target.height());
+    if (m_SourceRow == end) {
+      if (m_Bpp == 4) {
+        writeRow<4>();
+      } else {
+        writeRow<3>();
+      }
+      m_RowsInSum = 0;
+      ++m_TargetRow;
+    }
+  }
+
+private:
+  // write the averages as 0xAARRGGBB, opaque if there is no alpha, and reset the
+  // sums for the next row
+  template <int Bpp>
+  void writeRow()
+  {
+    uint32_t* out = reinterpret_cast<uint32_t*>(m_Target.scanLine(m_TargetRow));
+    uint32_t* sum = m_Sums.data();
+    for (int x = 0; x < m_Target.width(); ++x) {
+      // 64-bit, since a pixel of a large screenshot can cover a lot of them
+      uint64_t channels[Bpp] = {};
+      for (int sx = m_Columns[x]; sx < m_Columns[x + 1]; ++sx, sum += Bpp) {
+        for (int c = 0; c < Bpp; ++c) {
+          channels[c] += sum[c];
+          sum[c] = 0;
+        }
+      }
+
+      const uint64_t count = uint64_t(m_Columns[x + 1] - m_Columns[x]) * m_RowsInSum;
+      uint32_t average[4]  = {0, 0, 0, 255};
+      for (int c = 0; c < Bpp; ++c) {
+        // 32-bit division whenever possible, it is much faster
+        const uint64_t rounded = channels[c] + count / 2;
+        average[c]             = rounded <= std::numeric_limits<uint32_t>::max()
+                                     ? uint32_t(rounded) / uint32_t(count)
+                                     : uint32_t(rounded / count);
+      }
+      out[x] =
+          (average[3] << 24) | (average[0] << 16) | (average[1] << 8) | average[2];
+    }
+  }
+
+  QImage& m_Target;
+  int m_SourceHeight;
+  int m_Bpp;
+  std::vector<int> m_Columns;
+  std::vector<uint32_t> m_Sums;
+  int m_SourceRow = 0;
+  int m_TargetRow = 0;
+  int m_RowsInSum = 0;
+};
+}  // namespace
+
+QImage GamebryoSaveFile::readThumbnail(uint32_t width, uint32_t height,
+                                       int targetWidth, bool alpha)
+{
+  const int bpp               = alpha ? 4 : 3;
+  const std::size_t rowSize   = static_cast<std::size_t>(width) * bpp;
+  const QImage::Format format =
+      alpha ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+
+  if (height == 0) {
+    return QImage();
+  }
+
+  const qint64 remaining = file().size() - file().pos();
+  if (remaining < 0 || static_cast<std::size_t>(remaining) / rowSize < height) {
+    throw std::runtime_error("unexpected end of file");
+  }
+
+  // same size as QImage::scaledToWidth()
+  const int targetHeight =
+      std::max(1, qRound(qreal(height) * targetWidth / qreal(width)));
+
+  QImage thumbnail(targetWidth, targetHeight, format);
+  if (thumbnail.isNull()) {
+    throw std::runtime_error("invalid screenshot size");
+  }
+  BoxDownscaler scaler(thumbnail, width, height, bpp);
+  // the thumbnail and the two arrays of the scaler
+  Stats::count(Stats::Allocations, 3);
+  for (uint32_t y = 0; y < height; ++y) {
+    scaler.addRow(reinterpret_cast<const uchar*>(m_FileSource->bytes(rowSize)));
+  }
+
+  return thumbnail;
+}
+
+void GamebryoSaveFile::setCompressionType(uint16_t compressionType)
+{
+  m_CompressionType = compressionType;
+}
+
+void GamebryoSaveFile::closeCompressedData()
+{
+  // the buffers are kept for the next save parsed on this thread
+  m_BodySource.reset();
+  m_Body = m_FileSource.get();
+}
+
+bool GamebryoSaveFile::openCompressedData(int bytesToIgnore)
+{
+  closeCompressedData();
+
+  bool result = true;
+  if (m_CompressionType == 0) {
+    result = false;
+  } else if (m_CompressionType == 1) {
+    uint64_t firstChunk;
+    read(firstChunk);
+    uint64_t uncompressedSize;
+    read(uncompressedSize);
+
+    auto source =
+        std::make_unique<ZlibSource>(file(), *m_Scratch, firstChunk, uncompressedSize);
+    Stats::count(Stats::Allocations);
+    result       = source->nextChunk();
+    m_BodySource = std::move(source);
+  } else if (m_CompressionType == 2) {
+    uint32_t uncompressedSize;
+    read(uncompressedSize);
+    uint32_t compressedSize;
+    read(compressedSize);
+
+    // LZ4 works with int sizes, and the block cannot be larger than the file
+    const qint64 remaining = file().size() - file().pos();
+    if (compressedSize > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+        compressedSize > remaining) {
+      throw std::runtime_error("unexpected end of file");
+    }
+
+    const char* data;
+    if (file().map() != nullptr) {
+      // decompress straight from the mapped file
+      data = m_FileSource->bytes(compressedSize);
+    } else {
+      // read the block in place rather than through the read ahead buffer
+      resizeBuffer(m_Scratch->compressed, compressedSize);
+      if (file().readSome(m_Scratch->compressed.data(), compressedSize) !=
+          compressedSize) {
+        throw std::runtime_error("unexpected end of file");
+      }
+      data = m_Scratch->compressed.constData();
+    }
+
+    // nothing is decoded until the first read
+    m_BodySource = std::make_unique<Lz4Source>(*m_Scratch, data, compressedSize,
+                                               uncompressedSize);
+    Stats::count(Stats::Allocations);
+  } else {
+    qWarning("Please create an issue on the MO github labeled \"Found unknown "
+             "Compressed\" with your savefile attached");
+    m_BodySource = std::make_unique<NullSource>(m_Scratch->spill);
+    Stats::count(Stats::Allocations);
+    result       = false;
+  }
+
+  if (m_BodySource) {
+    m_Body = m_BodySource.get();
+  }
+  if (result && bytesToIgnore > 0) {
+    m_Body->skip(bytesToIgnore);
+  } else if (m_CompressionType == 0 && bytesToIgnore > 0) {
+    // Just to make certain
+    m_Body->skip(bytesToIgnore);
+  }
+  return result;
+}
+
+bool GamebryoSaveFile::readNextChunk()
+{
+  if (auto zlib = dynamic_cast<ZlibSource*>(m_BodySource.get())) {
+    return zlib->nextChunk();
+  }
+  return false;
+}
+
+template <typename T>
+T GamebryoSaveFile::readBody(int bytesToIgnore)
+{
+  if (bytesToIgnore > 0) {
+    m_Body->skip(bytesToIgnore);
+  }
+  T value;
+  m_Body->read(value);
+  return value;
+}
+
+uint8_t GamebryoSaveFile::readChar(int bytesToIgnore)
+{
+  return readBody<uint8_t>(bytesToIgnore);
+}
+
+uint16_t GamebryoSaveFile::readShort(int bytesToIgnore)
+{
+  return readBody<uint16_t>(bytesToIgnore);
+}
+
+uint32_t GamebryoSaveFile::readInt(int bytesToIgnore)
+{
+  return readBody<uint32_t>(bytesToIgnore);
+}
+
+uint64_t GamebryoSaveFile::readLong(int bytesToIgnore)
+{
+  return readBody<uint64_t>(bytesToIgnore);
+}
+
+float_t GamebryoSaveFile::readFloat(int bytesToIgnore)
+{
+  return readBody<float_t>(bytesToIgnore);
+}
+
+QStringList GamebryoSaveFile::readPlugins(int bytesToIgnore, int extraData,
+                                          const QStringList& corePlugins)
+{
+  return readPluginData(readBody<uint8_t>(bytesToIgnore), extraData, corePlugins);
+}
+
+QStringList GamebryoSaveFile::readLightPlugins(int bytesToIgnore, int extraData,
+                                               const QStringList& corePlugins)
+{
+  return readPluginData(readBody<uint16_t>(bytesToIgnore), extraData, corePlugins);
+}
+
+QStringList GamebryoSaveFile::readMediumPlugins(int bytesToIgnore, int extraData,
+                                                const QStringList& corePlugins)
+{
+  if (m_CompressionType != 1) {
+    return {};
+  }
+  return readPluginData(readBody<uint32_t>(bytesToIgnore), extraData, corePlugins);
+}
+
+QStringList GamebryoSaveFile::readPluginData(uint32_t count, int extraData,
+                                             const QStringList corePlugins)
+{
+  Stats::Timer timer(Stats::Plugins);
+
+  // names are decoded in the same string and the list gets the pooled copies,
+  // so only names that are new to the pool allocate, and the pool keeps their
+  // ids so that GamebryoSaveGame does not look the names up again
+  auto& names = GamebryoPluginNames::instance();
+  QStringList plugins;
+  std::vector<GamebryoPluginNames::Id> ids;
+  plugins.reserve(std::min<uint32_t>(count, MAX_PLUGINS_RESERVE));
+  ids.reserve(std::min<uint32_t>(count, MAX_PLUGINS_RESERVE));
+  Stats::count(Stats::Allocations, 2);
+  QString name;
+  for (std::size_t i = 0; i < count; ++i) {
+    readString(*m_Body, name);
+    GamebryoPluginNames::Id id;
+    plugins.push_back(names.pooled(name, &id));
+    ids.push_back(id);
+    if (extraData) {
+      bool isCustomPlugin;
+      if (extraData > 1) {
+        m_Body->read(isCustomPlugin);
+      } else {
+        isCustomPlugin = !corePlugins.contains(name);
+      }
+      if (isCustomPlugin) {
+        QString creationName;
+        QString creationId;
+        uint16_t flagsSize;
+        uint8_t isCreation;
+        readString(*m_Body, creationName);
+        readString(*m_Body, creationId);
+        m_Body->read(flagsSize);
+        m_Body->skip(flagsSize);
+        m_Body->read(isCreation);
+      }
+    }
+  }
+  names.remember(plugins, std::move(ids));
+  return plugins;
+}
+
+void GamebryoSaveFile::close()
+{
+  m_BodySource.reset();
+  m_Body = m_FileSource.get();
+  file().close();
+}
@@ -0,0 +1,304 @@
+#ifndef GAMEBRYOSAVEFILE_H
+#define GAMEBRYOSAVEFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stddef.h>
+#include <stdexcept>
+#include <type_traits>
+
+// Reader for the save files of Gamebryo and Creation engine games.
+//
+// This only depends on Qt, zlib and lz4, and all the fields it reads have a
+// fixed width, so it builds and behaves the same on any platform. The game
+// plugins use it as GamebryoSaveGame::FileWrapper.
+class GamebryoSaveFile
+{
+public:
+  enum class StringType
+  {
+    TYPE_BZSTRING,
+    TYPE_BSTRING,
+    TYPE_WSTRING
+  };
+
+  enum class StringFormat
+  {
+    UTF8,
+    LOCAL8BIT
+  };
+
+  // a prefix large enough for the header fields of all the supported games
+  static constexpr std::size_t PROBE_SIZE = 8192;
+
+  /**
+   * @brief Construct the save file information.
+   *
+   * @param filepath The path to the save file.
+   * @params expected Expecte bytes at start of file.
+   * @param prefix If not 0, only the first prefix bytes are read, in a single
+   *     read, and reading past them throws. Used to probe the header.
+   *
+   **/
+  GamebryoSaveFile(QString const& filepath, QString const& expected,
+                   std::size_t prefix = 0);
+
+  ~GamebryoSaveFile();
+
+  /**
+   * @brief While alive, a save opened with a prefix on this thread for the given
+   *     file reads the prefix from `data`, e.g. read by GamebryoBatchReader,
+   *     rather than from the file, which is then not opened at all.
+   */
+  class Prefetched
+  {
+  public:
+    Prefetched(QString const& filepath, QByteArray const& data);
+    ~Prefetched();
+
+    Prefetched(Prefetched const&)            = delete;
+    Prefetched& operator=(Prefetched const&) = delete;
+
+  private:
+    friend class GamebryoSaveFile;
+
+    QString const& m_Filepath;
+    QByteArray const& m_Data;
+    Prefetched* m_Previous;
+  };
+
+  /**
+   * @brief While alive, saves opened on this thread are read through QFile rather
+   *     than mapped, as when mapping fails, e.g. to test that path.
+   */
+  class Unmapped
+  {
+  public:
+    Unmapped();
+    ~Unmapped();
+
+    Unmapped(Unmapped const&)            = delete;
+    Unmapped& operator=(Unmapped const&) = delete;
+
+  private:
+    bool m_Previous;
+  };
+
+  /** Set this for save games that have a marker at the end of each
+   * field. Specifically fallout
+   **/
+  void setHasFieldMarkers(bool);
+
+  /** Set bz string mode (1 byte length, null terminated)
+   **/
+  void setPluginString(StringType);
+
+  /** Set string format (utf-8, windows local 8 bit strings)
+   **/
+  void setPluginStringFormat(StringFormat);
+
+  template <typename T>
+  void skip(int count = 1)
+  {
+    if (count >= 0) {
+      m_FileSource->skip(static_cast<std::size_t>(count) * sizeof(T));
+    } else {
+      rewind(static_cast<std::size_t>(-count) * sizeof(T));
+    }
+  }
+
+  template <typename T>
+  void read(T& value)
+  {
+    m_FileSource->read(value);
+  }
+
+  void seek(uint64_t pos);
+
+  void read(void* buff, std::size_t length);
+
+  /* Reads RGB image from save
+   * Assumes picture dimentions come immediately before the save
+   */
+  QImage readImage(int scale = 0, bool alpha = false);
+
+  /* Reads RGB image from save
+   * If scale is smaller than the width, the image is downscaled while it is
+   * read and the full size image is never built
+   */
+  QImage readImage(uint32_t width, uint32_t height, int scale = 0,
+                   bool alpha = false);
+
+  /* Sets the compression type. */
+  void setCompressionType(uint16_t type);
+
+  /* open the compressed block, data is only uncompressed as it is read so
+   * closing the block right after the needed fields avoids decompressing
+   * the rest of it
+   */
+  bool openCompressedData(int bytesToIgnore = 0);
+
+  /* move to the next compressed block */
+  bool readNextChunk();
+
+  /* frees the uncompressed block */
+  void closeCompressedData();
+
+  /* Read the save game version in the compressed block */
+  uint8_t readChar(int bytesToIgnore = 0);
+
+  uint16_t readShort(int bytesToIgnore = 0);
+
+  uint32_t readInt(int bytesToIgnore = 0);
+
+  uint64_t readLong(int bytesToIgnore = 0);
+
+  float_t readFloat(int bytesToIgnore = 0);
+
+  /* Read the plugin list */
+  QStringList readPlugins(int bytesToIgnore = 0, int extraData = 0,
+                          const QStringList& corePlugins = {});
+
+  /* Read the light plugin list */
+  QStringList readLightPlugins(int bytesToIgnore = 0, int extraData = 0,
+                               const QStringList& corePlugins = {});
+
+  /* Read the medium plugin list */
+  QStringList readMediumPlugins(int bytesToIgnore = 0, int extraData = 0,
+                                const QStringList& corePlugins = {});
+
+  void close();
+
+private:
+  // A stream of bytes read through a window of contiguous bytes [m_Pos, m_End)
+  // that is refilled once empty, so that reading a value is usually a bounds
+  // check and a copy whatever the bytes come from.
+  class Source
+  {
+  public:
+    Source(QByteArray& spill) : m_Spill(spill) {}
+    virtual ~Source() = default;
+
+    // skip a one byte marker after each value read with read<T>()
+    void setFieldMarkers(bool state) { m_FieldMarkers = state; }
+    bool hasFieldMarkers() const { return m_FieldMarkers; }
+
+    template <typename T>
+    void read(T& value)
+    {
+      static_assert(std::is_trivially_copyable_v<T>);
+      if (static_cast<std::size_t>(m_End - m_Pos) >= sizeof(T)) {
+        std::memcpy(&value, m_Pos, sizeof(T));
+        m_Pos += sizeof(T);
+      } else {
+        readMore(&value, sizeof(T));
+      }
+      if (m_FieldMarkers) {
+        skip(1);
+      }
+    }
+
+    void read(void* buff, std::size_t length)
+    {
+      if (static_cast<std::size_t>(m_End - m_Pos) >= length) {
+        std::memcpy(buff, m_Pos, length);
+        m_Pos += length;
+      } else {
+        readMore(buff, length);
+      }
+    }
+
+    void skip(std::size_t length)
+    {
+      if (static_cast<std::size_t>(m_End - m_Pos) >= length) {
+        m_Pos += length;
+      } else {
+        skipMore(length);
+      }
+    }
+
+    // the next `length` bytes, copied aside only if they are not contiguous,
+    // the pointer is only valid until the next read
+    const char* bytes(std::size_t length);
+
+  protected:
+    // called once the window is empty to make at least one more byte, and
+    // ideally `wanted` bytes, available, throws at the end of the stream
+    virtual void refill(std::size_t wanted) = 0;
+
+    virtual void skipMore(std::size_t length);
+
+    void readMore(void* buff, std::size_t length);
+
+    const char* m_Pos = nullptr;
+    const char* m_End = nullptr;
+
+  private:
+    QByteArray& m_Spill;
+    bool m_FieldMarkers = false;
+  };
+
+  // the file itself, the zlib chunks and the LZ4 block of compression types
+  // 1 and 2, and the body of saves with an unknown compression
+  class FileSource;
+  class ZlibSource;
+  class Lz4Source;
+  class NullSource;
+
+  QFile m_File;
+  StringType m_PluginString;
+  StringFormat m_PluginStringFormat;
+  uint16_t m_CompressionType = 0;
+
+  // Buffers and zlib state (zlib.h is private to this library), borrowed from
+  // a per-thread arena on construction and handed back on destruction, so
+  // that parsing saves one after the other on a thread reuses them.
+  struct Inflater;
+  struct Scratch;
+  std::unique_ptr<Scratch> m_Scratch;
+
+  // the file, read by read<T>() and friends, always a FileSource, and the
+  // decompressed body while it is open
+  std::unique_ptr<Source> m_FileSource;
+  std::unique_ptr<Source> m_BodySource;
+
+  // where readChar() and friends read, the body if it is open, the file
+  // otherwise
+  Source* m_Body = nullptr;
+
+private:
+  FileSource& file();
+
+  template <typename T>
+  T readBody(int bytesToIgnore);
+
+  void readString(Source& source, QString& value);
+
+  void rewind(std::size_t length);
+
+  static std::unique_ptr<Scratch>& threadScratch();
+
+  static Prefetched*& threadPrefetched();
+  static bool& threadUnmapped();
+
+  // read an image and box-filter it down to the given width, row by row
+  QImage readThumbnail(uint32_t width, uint32_t height, int targetWidth, bool alpha);
+
+  QStringList readPluginData(uint32_t count, int extraData,
+                             const QStringList corePlugins);
+};
+
+// explicit specializations cannot be declared in the class with conforming
+// compilers
+template <>
+void GamebryoSaveFile::read<QString>(QString& value);
+
+#endif  // GAMEBRYOSAVEFILE_H
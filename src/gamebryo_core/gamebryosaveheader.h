@@ -0,0 +1,24 @@
+#ifndef GAMEBRYOSAVEHEADER_H
+#define GAMEBRYOSAVEHEADER_H
+
+#include <QDateTime>
+#include <QString>
+
+#include <cstdint>
+
+/**
+ * @brief The fields of a save needed to list it, which all come from the start
+ *     of the file.
+ */
+struct GamebryoSaveHeader
+{
+  QString PCName;
+  uint16_t PCLevel = 0;
+  QString PCLocation;
+  uint32_t SaveNumber = 0;
+  QDateTime CreationTime;
+  bool LightEnabled  = false;
+  bool MediumEnabled = false;
+};
+
+#endif  // GAMEBRYOSAVEHEADER_H
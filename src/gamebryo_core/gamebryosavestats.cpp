@@ -0,0 +1,144 @@
+#include "gamebryosavestats.h"
+
+#include <chrono>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+struct ThreadState
+{
+  GamebryoSaveStats::Record* record = nullptr;
+  GamebryoSaveStats::Stage stage    = GamebryoSaveStats::Header;
+  Clock::time_point since;
+};
+
+thread_local ThreadState state;
+
+// charge the time since the last switch to the current stage
+void switchStage(GamebryoSaveStats::Stage stage)
+{
+  const auto now = Clock::now();
+  state.record->Nanoseconds[state.stage] +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - state.since).count();
+  state.stage = stage;
+  state.since = now;
+}
+}  // namespace
+
+const char* GamebryoSaveStats::stageName(Stage stage)
+{
+  switch (stage) {
+  case Open:
+    return "open";
+  case Magic:
+    return "magic";
+  case Header:
+    return "header";
+  case Decompress:
+    return "decompress";
+  case Plugins:
+    return "plugins";
+  case Screenshot:
+    return "screenshot";
+  default:
+    return "?";
+  }
+}
+
+int64_t GamebryoSaveStats::Record::totalNanoseconds() const
+{
+  int64_t total = 0;
+  for (int64_t ns : Nanoseconds) {
+    total += ns;
+  }
+  return total;
+}
+
+GamebryoSaveStats::Record& GamebryoSaveStats::Record::operator+=(Record const& other)
+{
+  for (int i = 0; i < StageCount; ++i) {
+    Nanoseconds[i] += other.Nanoseconds[i];
+  }
+  for (int i = 0; i < CounterCount; ++i) {
+    Counters[i] += other.Counters[i];
+  }
+  return *this;
+}
+
+GamebryoSaveStats::Record GamebryoSaveStats::Report::total() const
+{
+  Record total;
+  for (auto& record : Saves) {
+    total += record;
+  }
+  return total;
+}
+
+QString GamebryoSaveStats::Report::summary() const
+{
+  auto ms = [](int64_t ns) {
+    return QString::number(ns / 1e6, 'f', 1);
+  };
+
+  const Record sum = total();
+  QString stages;
+  for (int i = 0; i < StageCount; ++i) {
+    stages += QString("%1%2 %3")
+                  .arg(QLatin1String(i > 0 ? ", " : ""))
+                  .arg(QLatin1String(stageName(static_cast<Stage>(i))))
+                  .arg(ms(sum.Nanoseconds[i]));
+  }
+
+  return QString("listed %1 saves in %2 ms (%3 unchanged, %4 from the cache), "
+                 "parsed %5 saves (%6 failed) in %7 ms: %8, %9 KiB read, "
+                 "%10 KiB inflated, %11 syscalls, %12 allocations")
+      .arg(Listed)
+      .arg(ms(WallNanoseconds))
+      .arg(IndexHits)
+      .arg(CacheHits)
+      .arg(Saves.size())
+      .arg(Failed)
+      .arg(ms(sum.totalNanoseconds()))
+      .arg(stages)
+      .arg(sum.Counters[BytesRead] / 1024)
+      .arg(sum.Counters[BytesInflated] / 1024)
+      .arg(sum.Counters[Syscalls])
+      .arg(sum.Counters[Allocations]);
+}
+
+GamebryoSaveStats::Scope::Scope(Record& record)
+{
+  state.record = &record;
+  state.stage  = Header;
+  state.since  = Clock::now();
+}
+
+GamebryoSaveStats::Scope::~Scope()
+{
+  switchStage(Header);
+  state.record = nullptr;
+}
+
+GamebryoSaveStats::Timer::Timer(Stage stage)
+    : m_Active(state.record != nullptr), m_Previous(state.stage)
+{
+  if (m_Active) {
+    switchStage(stage);
+  }
+}
+
+GamebryoSaveStats::Timer::~Timer()
+{
+  // the scope may have ended in between if the timer outlives it
+  if (m_Active && state.record != nullptr) {
+    switchStage(m_Previous);
+  }
+}
+
+void GamebryoSaveStats::count(Counter counter, uint64_t value)
+{
+  if (state.record != nullptr) {
+    state.record->Counters[counter] += value;
+  }
+}
@@ -0,0 +1,124 @@
+#ifndef GAMEBRYOSAVESTATS_H
+#define GAMEBRYOSAVESTATS_H
+
+#include <QString>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Opt-in timers and counters for the parsing of saves.
+ *
+ * Nothing is collected unless a Scope is alive on the thread parsing the save,
+ * so the instrumentation left in the reader only costs a thread-local lookup
+ * per stage and per refill otherwise.
+ *
+ * Stages measure self time: a stage entered within another one pauses it, e.g.
+ * the time spent inflating the plugin list is decompression, not plugins.
+ * Whatever is not in a stage is charged to the header.
+ */
+class GamebryoSaveStats
+{
+public:
+  enum Stage
+  {
+    Open,
+    Magic,
+    Header,
+    Decompress,
+    Plugins,
+    Screenshot,
+    StageCount
+  };
+
+  enum Counter
+  {
+    // bytes read from the file, or read through when it is mapped
+    BytesRead,
+    BytesInflated,
+    // calls that go to the system: open, stat, map, read, seek and close
+    Syscalls,
+    // buffers, decompression sources and images allocated by the reader
+    Allocations,
+    CounterCount
+  };
+
+  static const char* stageName(Stage stage);
+
+  struct Record
+  {
+    QString File;
+    std::array<int64_t, StageCount> Nanoseconds{};
+    std::array<uint64_t, CounterCount> Counters{};
+
+    int64_t totalNanoseconds() const;
+
+    Record& operator+=(Record const& other);
+  };
+
+  /**
+   * @brief What one listing of a directory did, with the records of the saves it
+   *     had to parse.
+   */
+  struct Report
+  {
+    // saves listed, including the ones that did not change since the previous
+    // listing and those served by the save game cache, which are not parsed
+    std::size_t Listed    = 0;
+    std::size_t IndexHits = 0;
+    std::size_t CacheHits = 0;
+
+    // saves parsed, including the ones that failed to parse
+    std::vector<Record> Saves;
+    std::size_t Failed = 0;
+
+    // wall-clock time of the listing, less than the sum of the records when the
+    // saves are parsed concurrently
+    int64_t WallNanoseconds = 0;
+
+    Record total() const;
+
+    // one line summary, for the log
+    QString summary() const;
+  };
+
+  /**
+   * @brief Collects what is parsed on the current thread into a record while
+   *     alive. Scopes do not nest.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope(Record& record);
+    ~Scope();
+
+    Scope(Scope const&)            = delete;
+    Scope& operator=(Scope const&) = delete;
+  };
+
+  /**
+   * @brief Charges the time it is alive to a stage, if a scope is alive.
+   */
+  class Timer
+  {
+  public:
+    explicit Timer(Stage stage);
+    ~Timer();
+
+    Timer(Timer const&)            = delete;
+    Timer& operator=(Timer const&) = delete;
+
+  private:
+    bool m_Active;
+    Stage m_Previous;
+  };
+
+  /**
+   * @brief Add to a counter of the current record, if a scope is alive.
+   */
+  static void count(Counter counter, uint64_t value = 1);
+};
+
+#endif  // GAMEBRYOSAVESTATS_H
@@ -0,0 +1,107 @@
+// Throughput of GamebryoSaveFile on synthetic saves, see GamebryoSaveGenerator,
+// with a body stored as is, as zlib chunks and as a LZ4 block, the argument 0, 1 and
+// 2 of each benchmark, e.g.
+//   bench_savefile --benchmark_filter=ParseMemory
+
+#include "gamebryosavegenerator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <array>
+#include <cstdint>
+
+namespace
+{
+struct SyntheticSave
+{
+  QString Path;
+  QByteArray Data;
+};
+
+// one save per compression, written once for all the benchmarks
+SyntheticSave const& syntheticSave(int64_t compression)
+{
+  static QTemporaryDir directory;
+  static std::array<SyntheticSave, 3> saves;
+
+  SyntheticSave& save = saves.at(static_cast<std::size_t>(compression));
+  if (save.Path.isEmpty()) {
+    GamebryoSaveGenerator::Options options;
+    options.Compression   = static_cast<uint16_t>(compression);
+    options.FieldMarkers  = true;
+    options.MediumPlugins = 100;
+
+    save.Path = directory.filePath(QString("save%1.synth").arg(compression));
+    GamebryoSaveGenerator::write(save.Path, options);
+    save.Data = GamebryoSaveGenerator::generate(options);
+  }
+  return save;
+}
+
+void setLabel(benchmark::State& state)
+{
+  static const char* const names[] = {"stored", "zlib", "lz4"};
+  state.SetLabel(names[state.range(0)]);
+}
+
+// what listing saves reads for each of them
+void BM_ProbeHeader(benchmark::State& state)
+{
+  SyntheticSave const& save = syntheticSave(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(GamebryoSaveGenerator::parse(
+        save.Path, GamebryoSaveGenerator::Fields::Header, 0,
+        GamebryoSaveFile::PROBE_SIZE));
+  }
+  state.SetItemsProcessed(state.iterations());
+  setLabel(state);
+}
+
+// the whole save from the file, as for the tooltip of a save
+void BM_ParseFile(benchmark::State& state)
+{
+  SyntheticSave const& save = syntheticSave(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(GamebryoSaveGenerator::parse(save.Path));
+  }
+  state.SetBytesProcessed(state.iterations() * save.Data.size());
+  setLabel(state);
+}
+
+// the same with the screenshot scaled down, as for the save list
+void BM_ParseThumbnail(benchmark::State& state)
+{
+  SyntheticSave const& save = syntheticSave(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(GamebryoSaveGenerator::parse(
+        save.Path, GamebryoSaveGenerator::Fields::All, 128));
+  }
+  state.SetBytesProcessed(state.iterations() * save.Data.size());
+  setLabel(state);
+}
+
+// the whole save from memory, which leaves out the file system
+void BM_ParseMemory(benchmark::State& state)
+{
+  SyntheticSave const& save = syntheticSave(state.range(0));
+  const std::size_t prefix  = static_cast<std::size_t>(save.Data.size());
+  for (auto _ : state) {
+    GamebryoSaveFile::Prefetched prefetched(save.Path, save.Data);
+    benchmark::DoNotOptimize(GamebryoSaveGenerator::parse(
+        save.Path, GamebryoSaveGenerator::Fields::All, 0, prefix));
+  }
+  state.SetBytesProcessed(state.iterations() * save.Data.size());
+  setLabel(state);
+}
+}  // namespace
+
+BENCHMARK(BM_ProbeHeader)->DenseRange(0, 2);
+BENCHMARK(BM_ParseFile)->DenseRange(0, 2);
+BENCHMARK(BM_ParseThumbnail)->DenseRange(0, 2);
+BENCHMARK(BM_ParseMemory)->DenseRange(0, 2);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,89 @@
+// Reading the screenshot of a save, at full size and as a thumbnail, against what was
+// done before the pixels were converted by GamebryoSaveFile itself: a QImage of the
+// raw pixels, copied and then scaled with QImage::scaledToWidth(). The arguments are
+// the alpha channel (0 or 1) and the width of the thumbnail (0 for full size), e.g.
+//   bench_screenshot --benchmark_filter=/1/320
+
+#include "gamebryosavegenerator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace
+{
+constexpr int WIDTH  = 1920;
+constexpr int HEIGHT = 1080;
+
+// a save holding little more than a screenshot, read from memory
+QByteArray const& syntheticSave(bool alpha)
+{
+  static QByteArray saves[2];
+
+  QByteArray& save = saves[alpha];
+  if (save.isEmpty()) {
+    GamebryoSaveGenerator::Options options;
+    options.Plugins          = 0;
+    options.LightPlugins     = 0;
+    options.ScreenshotWidth  = WIDTH;
+    options.ScreenshotHeight = HEIGHT;
+    options.Alpha            = alpha;
+    options.FillerSize       = 0;
+    save                     = GamebryoSaveGenerator::generate(options);
+  }
+  return save;
+}
+
+void setCounters(benchmark::State& state)
+{
+  const int bpp = state.range(0) ? 4 : 3;
+  state.SetBytesProcessed(state.iterations() * WIDTH * HEIGHT * bpp);
+  state.SetLabel(state.range(0) ? "rgba" : "rgb");
+}
+
+void BM_Screenshot(benchmark::State& state)
+{
+  static const QString path = "screenshot.synth";
+  QByteArray const& save    = syntheticSave(state.range(0) != 0);
+  const std::size_t prefix  = static_cast<std::size_t>(save.size());
+  const int scale           = static_cast<int>(state.range(1));
+
+  for (auto _ : state) {
+    GamebryoSaveFile::Prefetched prefetched(path, save);
+    benchmark::DoNotOptimize(GamebryoSaveGenerator::parse(
+        path, GamebryoSaveGenerator::Fields::All, scale, prefix));
+  }
+  setCounters(state);
+}
+
+// raw pixels of the same size, in memory already since reading them from the save
+// does not differ, in the formats and with the calls of the former readImage()
+void BM_QtScreenshot(benchmark::State& state)
+{
+  const bool alpha = state.range(0) != 0;
+  const int scale  = static_cast<int>(state.range(1));
+  const QByteArray pixels(qsizetype(WIDTH) * HEIGHT * (alpha ? 4 : 3), '\x7f');
+  const QImage image(reinterpret_cast<const uchar*>(pixels.constData()), WIDTH, HEIGHT,
+                     alpha ? QImage::Format_RGBA8888_Premultiplied
+                           : QImage::Format_RGB888);
+
+  for (auto _ : state) {
+    if (scale > 0) {
+      benchmark::DoNotOptimize(image.copy().scaledToWidth(scale));
+    } else {
+      benchmark::DoNotOptimize(image.copy());
+    }
+  }
+  setCounters(state);
+}
+}  // namespace
+
+BENCHMARK(BM_Screenshot)->ArgsProduct({{0, 1}, {0, 320}});
+BENCHMARK(BM_QtScreenshot)->ArgsProduct({{0, 1}, {0, 320}});
+
+BENCHMARK_MAIN();
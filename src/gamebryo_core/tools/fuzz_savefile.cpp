@@ -0,0 +1,82 @@
+// Fuzzes GamebryoSaveFile with the input read as a synthetic save, see
+// GamebryoSaveGenerator, from memory and from a file, both mapped and read through
+// QFile, which all go through different code. With GAMEBRYO_CORE_LIBFUZZER this is
+// a libFuzzer target, which can be seeded with savegen:
+//   savegen --count 4 --filler 4096 corpus/ && fuzz_savefile corpus/
+// Otherwise it runs the files given on the command line, e.g. to replay a crash.
+
+#include "gamebryosavegenerator.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+namespace
+{
+// the screenshot as is and as a thumbnail, which are read differently
+void parse(QString const& path, std::size_t prefix)
+{
+  for (int scale : {0, 64}) {
+    try {
+      GamebryoSaveGenerator::parse(path, GamebryoSaveGenerator::Fields::All, scale,
+                                   prefix);
+    } catch (std::exception&) {
+      // malformed saves are expected to throw, only crashes are of interest
+    }
+  }
+}
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, std::size_t size)
+{
+  static QTemporaryDir directory;
+  static const QString path = directory.filePath("fuzz.synth");
+
+  const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(data),
+                                                   static_cast<qsizetype>(size));
+  {
+    // the file is not opened, the save is read from the prefetched data
+    GamebryoSaveFile::Prefetched prefetched(path, bytes);
+    parse(path, std::max<std::size_t>(size, 1));
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size()) {
+    std::fprintf(stderr, "failed to write %s\n", qUtf8Printable(path));
+    std::abort();
+  }
+  file.close();
+
+  parse(path, 0);
+  {
+    GamebryoSaveFile::Unmapped unmapped;
+    parse(path, 0);
+  }
+
+  return 0;
+}
+
+#ifndef GAMEBRYO_CORE_LIBFUZZER
+int main(int argc, char* argv[])
+{
+  for (int i = 1; i < argc; ++i) {
+    QFile file(QString::fromLocal8Bit(argv[i]));
+    if (!file.open(QIODevice::ReadOnly)) {
+      std::fprintf(stderr, "failed to open %s\n", argv[i]);
+      return 1;
+    }
+    const QByteArray data = file.readAll();
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(data.constData()),
+                           static_cast<std::size_t>(data.size()));
+  }
+  return 0;
+}
+#endif
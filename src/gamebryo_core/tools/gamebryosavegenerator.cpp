@@ -0,0 +1,351 @@
+#include "gamebryosavegenerator.h"
+
+#include <QFile>
+
+#include <lz4.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+using StringType = GamebryoSaveFile::StringType;
+
+constexpr uint32_t HEADER_VERSION = 1;
+constexpr uint8_t FORM_VERSION    = 1;
+
+// after the filler, so that reading it checks that the whole body was read
+constexpr uint32_t BODY_END = 0x21444e45;  // "END!"
+
+// flags stored right after the magic, which say how to read the rest
+constexpr uint8_t FLAG_MARKERS     = 0x01;
+constexpr uint8_t FLAG_ALPHA       = 0x08;
+constexpr int STRING_TYPE_SHIFT    = 1;
+constexpr uint8_t STRING_TYPE_MASK = 0x03;
+
+// bytes, generous for a screenshot but far from what QByteArray can hold
+constexpr uint64_t MAX_SCREENSHOT_SIZE = 1ull << 30;
+
+// the same sequence on every platform, unlike the standard distributions
+class Random
+{
+public:
+  explicit Random(uint32_t seed) : m_State(seed * 2654435761u + 1) {}
+
+  uint32_t next()
+  {
+    m_State = m_State * 1664525u + 1013904223u;
+    return m_State >> 8;
+  }
+
+private:
+  uint32_t m_State;
+};
+
+// Writes fields the way GamebryoSaveFile reads them, with a marker after each
+// value and around the strings if enabled.
+class Writer
+{
+public:
+  Writer(QByteArray& out, bool markers, StringType stringType)
+      : m_Out(out), m_Markers(markers), m_StringType(stringType)
+  {}
+
+  template <typename T>
+  void write(T value)
+  {
+    writeBytes(&value, sizeof(T));
+    marker();
+  }
+
+  void write(QString const& value)
+  {
+    const QByteArray bytes = value.toUtf8();
+    if (m_StringType == StringType::TYPE_WSTRING) {
+      write(static_cast<uint16_t>(bytes.size()));
+    } else if (m_StringType == StringType::TYPE_BZSTRING) {
+      write(static_cast<uint8_t>(bytes.size() + 1));
+    } else {
+      write(static_cast<uint8_t>(bytes.size()));
+    }
+    marker();
+    m_Out.append(bytes);
+    if (m_StringType == StringType::TYPE_BZSTRING) {
+      m_Out.append('\0');
+    }
+    marker();
+  }
+
+  void writeBytes(const void* data, std::size_t length)
+  {
+    m_Out.append(static_cast<const char*>(data), static_cast<qsizetype>(length));
+  }
+
+  void align(std::size_t alignment)
+  {
+    while (m_Out.size() % alignment != 0) {
+      m_Out.append('\0');
+    }
+  }
+
+private:
+  void marker()
+  {
+    if (m_Markers) {
+      m_Out.append('|');
+    }
+  }
+
+  QByteArray& m_Out;
+  bool m_Markers;
+  StringType m_StringType;
+};
+
+template <typename Count>
+void writePlugins(Writer& writer, QStringList const& plugins)
+{
+  writer.write(static_cast<Count>(plugins.size()));
+  for (QString const& plugin : plugins) {
+    writer.write(plugin);
+  }
+}
+
+void writeScreenshot(Writer& writer, GamebryoSaveGenerator::Options const& options)
+{
+  const uint32_t width  = options.ScreenshotWidth;
+  const uint32_t height = options.ScreenshotHeight;
+  const int bpp         = options.Alpha ? 4 : 3;
+  writer.write(width);
+  writer.write(height);
+
+  // gradients with some noise, so that scaling them averages different values
+  Random random(options.Seed);
+  QByteArray row(static_cast<qsizetype>(width) * bpp, '\0');
+  for (uint32_t y = 0; y < height; ++y) {
+    char* pixel = row.data();
+    for (uint32_t x = 0; x < width; ++x) {
+      const uint32_t noise = random.next() & 0x0f;
+      pixel[0] = static_cast<char>((x * 255 / std::max(width, 1u)) ^ noise);
+      pixel[1] = static_cast<char>((y * 255 / std::max(height, 1u)) ^ noise);
+      pixel[2] = static_cast<char>((x + y + options.Seed) & 0xff);
+      if (bpp == 4) {
+        pixel[3] = static_cast<char>(0xf0 | noise);
+      }
+      pixel += bpp;
+    }
+    writer.writeBytes(row.constData(), row.size());
+  }
+}
+
+void writeBody(Writer& writer, GamebryoSaveGenerator::Options const& options,
+               GamebryoSaveGenerator::Save const& save)
+{
+  writer.write(FORM_VERSION);
+  writePlugins<uint8_t>(writer, save.Plugins);
+  writePlugins<uint16_t>(writer, save.LightPlugins);
+  if (options.Compression == 1) {
+    writePlugins<uint32_t>(writer, save.MediumPlugins);
+  }
+
+  // low entropy bytes, which compress about as well as the rest of a save
+  Random random(options.Seed ^ 0x5a5a5a5a);
+  QByteArray filler(static_cast<qsizetype>(options.FillerSize), '\0');
+  for (char& byte : filler) {
+    byte = static_cast<char>(random.next() & 0x0f);
+  }
+  writer.write(options.FillerSize);
+  writer.writeBytes(filler.constData(), filler.size());
+  writer.write(BODY_END);
+}
+
+void compressZlib(Writer& writer, QByteArray const& body, uint32_t chunkSize)
+{
+  chunkSize = std::max(chunkSize, 1u);
+  for (qsizetype offset = 0; offset < body.size(); offset += chunkSize) {
+    const uLong length      = std::min<qsizetype>(chunkSize, body.size() - offset);
+    uLongf compressedLength = compressBound(length);
+    QByteArray chunk(static_cast<qsizetype>(compressedLength), '\0');
+    if (compress(reinterpret_cast<Bytef*>(chunk.data()), &compressedLength,
+                 reinterpret_cast<const Bytef*>(body.constData() + offset),
+                 length) != Z_OK) {
+      throw std::runtime_error("failed to compress the body");
+    }
+    writer.writeBytes(chunk.constData(), compressedLength);
+    writer.align(16);
+  }
+}
+
+QByteArray compressLz4(QByteArray const& body)
+{
+  if (body.size() > LZ4_MAX_INPUT_SIZE) {
+    throw std::invalid_argument("body too large for LZ4");
+  }
+  const int size = static_cast<int>(body.size());
+  QByteArray block(LZ4_compressBound(size), '\0');
+  const int compressed =
+      LZ4_compress_default(body.constData(), block.data(), size, block.size());
+  if (compressed <= 0) {
+    throw std::runtime_error("failed to compress the body");
+  }
+  block.resize(compressed);
+  return block;
+}
+}  // namespace
+
+GamebryoSaveGenerator::Save GamebryoSaveGenerator::expected(Options const& options)
+{
+  Save save;
+  save.SaveNumber = options.Seed + 1;
+  save.PCName     = QString("Synthetic %1").arg(options.Seed);
+  save.PCLevel    = 1 + options.Seed % 80;
+  save.PCLocation = QString("Location %1").arg(options.Seed % 50);
+
+  // the same names for every seed, like the saves of a playthrough
+  for (uint32_t i = 0; i < options.Plugins; ++i) {
+    const char* extension = i < 5 ? "esm" : "esp";
+    save.Plugins.append(QString("Synthetic Plugin %1.%2").arg(i).arg(extension));
+  }
+  for (uint32_t i = 0; i < options.LightPlugins; ++i) {
+    save.LightPlugins.append(QString("Synthetic Light %1.esl").arg(i));
+  }
+  if (options.Compression == 1) {
+    for (uint32_t i = 0; i < options.MediumPlugins; ++i) {
+      save.MediumPlugins.append(QString("Synthetic Medium %1.esm").arg(i));
+    }
+  }
+  return save;
+}
+
+QByteArray GamebryoSaveGenerator::generate(Options const& options)
+{
+  if (options.Plugins > std::numeric_limits<uint8_t>::max() ||
+      options.LightPlugins > std::numeric_limits<uint16_t>::max()) {
+    throw std::invalid_argument("too many plugins");
+  }
+  if (uint64_t(options.ScreenshotWidth) * options.ScreenshotHeight * 4 >
+      MAX_SCREENSHOT_SIZE) {
+    throw std::invalid_argument("screenshot too large");
+  }
+  if (options.Compression > 2) {
+    throw std::invalid_argument("unknown compression");
+  }
+
+  const Save save = expected(options);
+
+  QByteArray out(MAGIC);
+  uint8_t flags = static_cast<uint8_t>(static_cast<int>(options.StringType)
+                                       << STRING_TYPE_SHIFT);
+  if (options.FieldMarkers) {
+    flags |= FLAG_MARKERS;
+  }
+  if (options.Alpha) {
+    flags |= FLAG_ALPHA;
+  }
+  out.append(static_cast<char>(flags));
+
+  Writer writer(out, options.FieldMarkers, options.StringType);
+  writer.write(HEADER_VERSION);
+  writer.write(save.SaveNumber);
+  writer.write(save.PCName);
+  writer.write(save.PCLevel);
+  writer.write(save.PCLocation);
+  writeScreenshot(writer, options);
+  writer.write(options.Compression);
+
+  if (options.Compression == 0) {
+    writeBody(writer, options, save);
+    return out;
+  }
+
+  // compressed bodies have no markers
+  QByteArray body;
+  Writer bodyWriter(body, false, options.StringType);
+  writeBody(bodyWriter, options, save);
+
+  if (options.Compression == 1) {
+    // the offset of the first chunk is only known once the sizes are written
+    const qsizetype firstChunkAt = out.size();
+    writer.write(uint64_t(0));
+    writer.write(static_cast<uint64_t>(body.size()));
+    writer.align(16);
+    const uint64_t firstChunk = out.size();
+    std::memcpy(out.data() + firstChunkAt, &firstChunk, sizeof(firstChunk));
+    compressZlib(writer, body, options.ChunkSize);
+  } else {
+    const QByteArray block = compressLz4(body);
+    writer.write(static_cast<uint32_t>(body.size()));
+    writer.write(static_cast<uint32_t>(block.size()));
+    writer.writeBytes(block.constData(), block.size());
+  }
+
+  return out;
+}
+
+void GamebryoSaveGenerator::write(QString const& filepath, Options const& options)
+{
+  const QByteArray data = generate(options);
+  QFile file(filepath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+      file.write(data) != data.size()) {
+    throw std::runtime_error(
+        QString("failed to write %1").arg(filepath).toUtf8().constData());
+  }
+}
+
+GamebryoSaveGenerator::Save GamebryoSaveGenerator::parse(QString const& filepath,
+                                                         Fields fields, int scale,
+                                                         std::size_t prefix)
+{
+  GamebryoSaveFile file(filepath, MAGIC, prefix);
+
+  uint8_t flags;
+  file.read(&flags, sizeof(flags));
+  const uint8_t stringType = (flags >> STRING_TYPE_SHIFT) & STRING_TYPE_MASK;
+  if (stringType > static_cast<uint8_t>(StringType::TYPE_WSTRING)) {
+    throw std::runtime_error("invalid string type");
+  }
+  file.setHasFieldMarkers((flags & FLAG_MARKERS) != 0);
+  file.setPluginString(static_cast<StringType>(stringType));
+
+  uint32_t version;
+  file.read(version);
+  if (version != HEADER_VERSION) {
+    throw std::runtime_error("unknown header version");
+  }
+
+  Save save;
+  file.read(save.SaveNumber);
+  file.read(save.PCName);
+  file.read(save.PCLevel);
+  file.read(save.PCLocation);
+  if (fields == Fields::Header) {
+    return save;
+  }
+
+  save.Screenshot = file.readImage(scale, (flags & FLAG_ALPHA) != 0);
+
+  uint16_t compression;
+  file.read(compression);
+  file.setCompressionType(compression);
+  file.openCompressedData();
+
+  if (file.readChar() != FORM_VERSION) {
+    throw std::runtime_error("unknown form version");
+  }
+  save.Plugins       = file.readPlugins();
+  save.LightPlugins  = file.readLightPlugins();
+  save.MediumPlugins = file.readMediumPlugins();
+
+  const uint32_t fillerSize = file.readInt();
+  if (fillerSize > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+      file.readInt(static_cast<int>(fillerSize)) != BODY_END) {
+    throw std::runtime_error("invalid body");
+  }
+
+  file.closeCompressedData();
+  file.close();
+  return save;
+}
@@ -0,0 +1,116 @@
+#ifndef GAMEBRYOSAVEGENERATOR_H
+#define GAMEBRYOSAVEGENERATOR_H
+
+#include "gamebryosavefile.h"
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Synthetic saves for the fuzzer, the benchmarks and the savegen tool.
+ *
+ * The saves have a layout of their own, which goes through everything that
+ * GamebryoSaveFile reads for the games: field markers, the three string types,
+ * a screenshot, and a body that is stored as is, as zlib chunks or as a LZ4
+ * block, holding the plugin lists followed by filler. How the file must be read
+ * is stored in it, so parse() reads any of them the way a game plugin would.
+ */
+class GamebryoSaveGenerator
+{
+public:
+  // first bytes of the files
+  static constexpr const char* MAGIC = "MO2SYNTH";
+
+  struct Options
+  {
+    // 0 stores the body as is, 1 as zlib chunks and 2 as a LZ4 block, as the
+    // compression types of the games
+    uint16_t Compression = 0;
+
+    // markers after each field outside of a compressed body, as in Fallout
+    bool FieldMarkers = false;
+
+    GamebryoSaveFile::StringType StringType =
+        GamebryoSaveFile::StringType::TYPE_WSTRING;
+
+    // at most 255 plugins and 65535 light plugins, medium plugins are only
+    // written with zlib, the only compression they are read with
+    uint32_t Plugins       = 250;
+    uint32_t LightPlugins  = 500;
+    uint32_t MediumPlugins = 0;
+
+    uint32_t ScreenshotWidth  = 640;
+    uint32_t ScreenshotHeight = 360;
+    bool Alpha                = false;
+
+    // bytes after the plugin lists, which the games do not read
+    uint32_t FillerSize = 1 << 20;
+
+    // uncompressed bytes per zlib chunk
+    uint32_t ChunkSize = 1 << 18;
+
+    // varies the header, the screenshot and the filler, not the plugin names
+    uint32_t Seed = 0;
+  };
+
+  // fields of a save, as generated or as read back
+  struct Save
+  {
+    uint32_t SaveNumber = 0;
+    QString PCName;
+    uint32_t PCLevel = 0;
+    QString PCLocation;
+    QImage Screenshot;
+    QStringList Plugins;
+    QStringList LightPlugins;
+    QStringList MediumPlugins;
+  };
+
+  enum class Fields
+  {
+    // the fields before the screenshot, like probing a header
+    Header,
+    // the screenshot, the plugin lists and the filler as well
+    All
+  };
+
+  /**
+   * @return the fields a save generated with the given options reads as, except
+   *     for the screenshot.
+   */
+  static Save expected(Options const& options);
+
+  /**
+   * @return the content of a save generated with the given options.
+   *
+   * @throw std::invalid_argument if there are too many plugins or the screenshot
+   *     is too large.
+   */
+  static QByteArray generate(Options const& options);
+
+  /**
+   * @brief Write a save generated with the given options.
+   *
+   * @throw std::runtime_error if the file cannot be written.
+   */
+  static void write(QString const& filepath, Options const& options);
+
+  /**
+   * @brief Read a save with GamebryoSaveFile.
+   *
+   * @param scale Width the screenshot is scaled to, as for readImage().
+   * @param prefix If not 0, only the first prefix bytes of the file are read, or
+   *     the data of a GamebryoSaveFile::Prefetched alive on this thread.
+   *
+   * @throw std::runtime_error if the save is truncated or malformed.
+   */
+  static Save parse(QString const& filepath, Fields fields = Fields::All,
+                    int scale = 0, std::size_t prefix = 0);
+};
+
+#endif  // GAMEBRYOSAVEGENERATOR_H
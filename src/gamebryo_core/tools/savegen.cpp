@@ -0,0 +1,135 @@
+// Writes synthetic saves, see GamebryoSaveGenerator, e.g. to seed the corpus of
+// fuzz_savefile or to time listing a large saves directory:
+//   savegen --count 500 --compression lz4 --verify saves/
+
+#include "gamebryosavegenerator.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+
+namespace
+{
+uint32_t toUInt(QCommandLineParser const& parser, QString const& name)
+{
+  bool ok;
+  const uint32_t value = parser.value(name).toUInt(&ok);
+  if (!ok) {
+    throw std::invalid_argument(
+        QString("invalid value for --%1").arg(name).toUtf8().constData());
+  }
+  return value;
+}
+
+// header fields and plugin lists, the screenshot only by size
+bool matches(GamebryoSaveGenerator::Save const& read,
+             GamebryoSaveGenerator::Save const& expected,
+             GamebryoSaveGenerator::Options const& options)
+{
+  return read.SaveNumber == expected.SaveNumber && read.PCName == expected.PCName &&
+         read.PCLevel == expected.PCLevel && read.PCLocation == expected.PCLocation &&
+         read.Plugins == expected.Plugins &&
+         read.LightPlugins == expected.LightPlugins &&
+         read.MediumPlugins == expected.MediumPlugins &&
+         uint32_t(read.Screenshot.width()) == options.ScreenshotWidth &&
+         uint32_t(read.Screenshot.height()) == options.ScreenshotHeight;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Writes synthetic Gamebryo saves.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("directory", "Directory to write the saves to.");
+  parser.addOptions({
+      {"count", "Number of saves, each with its own seed.", "n", "1"},
+      {"seed", "Seed of the first save.", "seed", "0"},
+      {"compression", "Body compression: none, zlib or lz4.", "type", "zlib"},
+      {"markers", "Write field markers."},
+      {"strings", "String type: bz, b or w.", "type", "w"},
+      {"plugins", "Number of plugins, at most 255.", "n", "250"},
+      {"light", "Number of light plugins.", "n", "500"},
+      {"medium", "Number of medium plugins, only written with zlib.", "n", "0"},
+      {"width", "Width of the screenshot.", "pixels", "640"},
+      {"height", "Height of the screenshot.", "pixels", "360"},
+      {"alpha", "Write the screenshot with an alpha channel."},
+      {"filler", "Bytes after the plugin lists.", "bytes", "1048576"},
+      {"chunk", "Uncompressed bytes per zlib chunk.", "bytes", "262144"},
+      {"verify", "Read each save back and check its fields."},
+  });
+  parser.process(app);
+
+  if (parser.positionalArguments().size() != 1) {
+    parser.showHelp(1);
+  }
+  const QDir directory(parser.positionalArguments().first());
+
+  try {
+    GamebryoSaveGenerator::Options options;
+
+    const QString compression = parser.value("compression");
+    if (compression == "none") {
+      options.Compression = 0;
+    } else if (compression == "zlib") {
+      options.Compression = 1;
+    } else if (compression == "lz4") {
+      options.Compression = 2;
+    } else {
+      throw std::invalid_argument("invalid value for --compression");
+    }
+
+    const QString strings = parser.value("strings");
+    if (strings == "bz") {
+      options.StringType = GamebryoSaveFile::StringType::TYPE_BZSTRING;
+    } else if (strings == "b") {
+      options.StringType = GamebryoSaveFile::StringType::TYPE_BSTRING;
+    } else if (strings == "w") {
+      options.StringType = GamebryoSaveFile::StringType::TYPE_WSTRING;
+    } else {
+      throw std::invalid_argument("invalid value for --strings");
+    }
+
+    options.FieldMarkers     = parser.isSet("markers");
+    options.Plugins          = toUInt(parser, "plugins");
+    options.LightPlugins     = toUInt(parser, "light");
+    options.MediumPlugins    = toUInt(parser, "medium");
+    options.ScreenshotWidth  = toUInt(parser, "width");
+    options.ScreenshotHeight = toUInt(parser, "height");
+    options.Alpha            = parser.isSet("alpha");
+    options.FillerSize       = toUInt(parser, "filler");
+    options.ChunkSize        = toUInt(parser, "chunk");
+
+    if (!directory.exists() && !QDir().mkpath(directory.path())) {
+      throw std::runtime_error("failed to create the directory");
+    }
+
+    const uint32_t seed  = toUInt(parser, "seed");
+    const uint32_t count = toUInt(parser, "count");
+    for (uint32_t i = 0; i < count; ++i) {
+      options.Seed       = seed + i;
+      const QString name = QString("save%1.synth").arg(options.Seed);
+      const QString path = directory.filePath(name);
+      GamebryoSaveGenerator::write(path, options);
+
+      if (parser.isSet("verify") &&
+          !matches(GamebryoSaveGenerator::parse(path),
+                   GamebryoSaveGenerator::expected(options), options)) {
+        std::fprintf(stderr, "%s does not read back as written\n",
+                     qUtf8Printable(path));
+        return 1;
+      }
+    }
+  } catch (std::exception& e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
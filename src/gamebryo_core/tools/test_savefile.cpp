@@ -0,0 +1,105 @@
+// Checks of GamebryoSaveFile on files that are not mapped, read through QFile as when
+// mapping fails, which the synthetic saves of the other tools do not go through as
+// precisely. Run by ctest, or on its own, and exits with 1 on the first failure.
+
+#include "gamebryosavefile.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+namespace
+{
+const char* const MAGIC = "MO2TEST";
+
+// byte of the test files at the given offset, varying enough that reading from the
+// wrong offset does not go unnoticed
+char patternAt(qint64 offset)
+{
+  return static_cast<char>(offset ^ (offset >> 8) ^ (offset >> 16));
+}
+
+// the magic, then the sizes of a LZ4 block of compressed bytes, which are never
+// decompressed, and the pattern up to the end
+QByteArray lz4File(uint32_t compressedSize)
+{
+  const qint64 header = qsizetype(std::strlen(MAGIC)) + 8;
+  QByteArray data(header + compressedSize + 4096, '\0');
+  for (qsizetype i = 0; i < data.size(); ++i) {
+    data[i] = patternAt(i);
+  }
+
+  const uint32_t uncompressedSize = compressedSize;
+  std::memcpy(data.data(), MAGIC, std::strlen(MAGIC));
+  std::memcpy(data.data() + header - 8, &uncompressedSize, 4);
+  std::memcpy(data.data() + header - 4, &compressedSize, 4);
+  return data;
+}
+
+bool check(bool condition, const char* what)
+{
+  if (!condition) {
+    std::fprintf(stderr, "FAILED: %s\n", what);
+  }
+  return condition;
+}
+
+// a LZ4 block larger than the read ahead is read straight from the file, past the
+// block read ahead for the header, which seeking back must not read from
+bool testSeekAfterLargeRead(QString const& path)
+{
+  const uint32_t compressedSize = 200000;
+  const QByteArray data         = lz4File(compressedSize);
+
+  QFile out(path);
+  if (!out.open(QIODevice::WriteOnly) || out.write(data) != data.size()) {
+    return check(false, "writing the LZ4 file");
+  }
+  out.close();
+
+  GamebryoSaveFile::Unmapped unmapped;
+  GamebryoSaveFile file(path, MAGIC);
+  file.setCompressionType(2);
+  file.openCompressedData();
+  file.closeCompressedData();
+
+  // offsets before the end of the block, in the block and in the header
+  const qint64 end = qsizetype(std::strlen(MAGIC)) + 8 + compressedSize;
+  for (qint64 offset : {end - 100, end - 40000, end - 70000, qint64(100), qint64(0)}) {
+    char read[16];
+    file.seek(offset);
+    file.read(read, sizeof(read));
+    if (std::memcmp(read, data.constData() + offset, sizeof(read)) != 0) {
+      std::fprintf(stderr, "at offset %lld: ", static_cast<long long>(offset));
+      return check(false, "reading back after a large read");
+    }
+  }
+  return true;
+}
+}  // namespace
+
+int main()
+{
+  QTemporaryDir directory;
+  if (!check(directory.isValid(), "creating a temporary directory")) {
+    return 1;
+  }
+
+  try {
+    if (!testSeekAfterLargeRead(directory.filePath("lz4.test"))) {
+      return 1;
+    }
+  } catch (std::exception& e) {
+    std::fprintf(stderr, "FAILED: %s\n", e.what());
+    return 1;
+  }
+
+  std::printf("ok\n");
+  return 0;
+}